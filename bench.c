@@ -0,0 +1,114 @@
+/* Benchmark client for dwm. Maps windows against the current display and
+ * measures how long dwm takes to manage them and to re-arrange the survivors
+ * when one goes away, reporting p50/p99 per batch. Run through bench.sh
+ * (make bench), which wraps dwm and this client in Xvfb; combine with the
+ * SIGUSR1 trace dump for dwm's internal arrange/drawbar histograms. */
+
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+
+#define MaxWindows 512
+
+static Display *display;
+static Window root;
+static Window windows[MaxWindows];
+static double samples[MaxWindows];
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void report(const char *name, int clients, double *values, int n) {
+    qsort(values, n, sizeof(double), compare_doubles);
+    printf("%-20s clients=%-4d n=%-4d p50=%7.3fms p99=%7.3fms max=%7.3fms\n",
+           name, clients, n, values[n / 2], values[(n * 99) / 100], values[n - 1]);
+}
+
+/* Wait for a ConfigureNotify that tells us dwm acted: on `window` itself when
+ * waiting for it to be managed, or on any *other* window when waiting for a
+ * re-arrange. Returns the elapsed time since `start`, or -1 on timeout. */
+static double wait_for_configure(Window window, int on_other, double start) {
+    struct pollfd fd = { .fd = ConnectionNumber(display), .events = POLLIN };
+    XEvent event;
+
+    for (;;) {
+        while (XPending(display)) {
+            XNextEvent(display, &event);
+            if (event.type != ConfigureNotify)
+                continue;
+            if (on_other ? event.xconfigure.window != window
+                         : event.xconfigure.window == window)
+                return now_ms() - start;
+        }
+        if (poll(&fd, 1, 2000) <= 0)
+            return -1;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    int count = argc > 1 ? atoi(argv[1]) : 50;
+    int i, n;
+
+    if (count < 1 || count > MaxWindows) {
+        fprintf(stderr, "bench: client count must be 1..%d\n", MaxWindows);
+        return 1;
+    }
+
+    display = XOpenDisplay(NULL);
+    if (!display) {
+        fprintf(stderr, "bench: cannot open display\n");
+        return 1;
+    }
+    root = DefaultRootWindow(display);
+
+    /* map-to-managed: time from XMapWindow until dwm configures the window */
+    for (i = 0; i < count; i++) {
+        char name[32];
+        double start;
+
+        windows[i] = XCreateSimpleWindow(display, root, 0, 0, 200, 200, 0, 0, 0);
+        snprintf(name, sizeof(name), "bench-%d", i);
+        XStoreName(display, windows[i], name);
+        XSelectInput(display, windows[i], StructureNotifyMask);
+
+        start = now_ms();
+        XMapWindow(display, windows[i]);
+        XFlush(display);
+        samples[i] = wait_for_configure(windows[i], 0, start);
+        if (samples[i] < 0) {
+            fprintf(stderr, "bench: timed out waiting for window %d to be managed\n", i);
+            return 1;
+        }
+    }
+    report("map-to-managed", count, samples, count);
+
+    /* unmap-to-rearrange: time from unmapping one client until a surviving
+     * client is reconfigured by the resulting arrange() */
+    n = 0;
+    for (i = count - 1; i > 0; i--) {
+        double start = now_ms();
+
+        XUnmapWindow(display, windows[i]);
+        XFlush(display);
+        samples[n] = wait_for_configure(windows[i], 1, start);
+        if (samples[n] >= 0)
+            n++;
+    }
+    if (n > 0)
+        report("unmap-to-rearrange", count, samples, n);
+
+    XCloseDisplay(display);
+    return 0;
+}
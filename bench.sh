@@ -0,0 +1,39 @@
+#!/bin/sh
+# Headless benchmark harness: runs dwm under Xvfb and drives it with the
+# bench client at several client counts, then asks dwm for its internal
+# latency histograms (SIGUSR1 trace dump). Invoked by `make bench-run`.
+
+display=":99"
+counts="${*:-1 10 50 100}"
+
+if ! command -v Xvfb >/dev/null 2>&1; then
+    echo "bench.sh: Xvfb not found, cannot run headless" >&2
+    exit 1
+fi
+
+Xvfb "$display" -screen 0 1920x1080x24 >/dev/null 2>&1 &
+xvfb_pid=$!
+trap 'kill $dwm_pid $xvfb_pid 2>/dev/null' EXIT INT TERM
+sleep 1
+
+DISPLAY="$display" ./dwm &
+dwm_pid=$!
+sleep 1
+
+if ! kill -0 "$dwm_pid" 2>/dev/null; then
+    echo "bench.sh: dwm did not start" >&2
+    exit 1
+fi
+
+for count in $counts; do
+    DISPLAY="$display" ./bench "$count" || exit 1
+done
+
+# dwm's own view of the same work: per-handler latency histograms
+rm -f /tmp/dwm-trace.log
+kill -USR1 "$dwm_pid"
+sleep 1
+if [ -r /tmp/dwm-trace.log ]; then
+    echo
+    sed -n '/latency histograms/,/recent spans/p' /tmp/dwm-trace.log | head -60
+fi
@@ -28,14 +28,17 @@ static const ColorSet colors[]      = {
 /* tagging */
 static const char *tags[] = { "Main", ">_", "3", "4", "5", "6", "7", "8", "9" };
 
-// static const Rule rules[] = {
-//     /* xprop(1):
-//      *    WM_CLASS(STRING) = instance, class
-//      *    WM_NAME(STRING) = title
-//      */
-//     // { .class = "Gimp",    .instance = NULL, .title = NULL, .tags = 0,      .isfloating = 1, .monitor_number = -1 },
-//     // { .class = "Firefox", .instance = NULL, .title = NULL, .tags = 1 << 8, .isfloating = 0, .monitor_number = -1 },
-// };
+static const Rule rules[] = {
+    /* xprop(1):
+     *    WM_CLASS(STRING) = instance, class
+     *    WM_NAME(STRING) = title
+     *
+     * A rule without a title matches class/instance exactly (hash lookup);
+     * a rule with a title falls back to substring matching on all fields.
+     */
+    { .class = "Gimp",    .instance = NULL, .title = NULL, .tags = 0,      .isfloating = 1, .monitor_number = -1 },
+    { .class = "Firefox", .instance = NULL, .title = NULL, .tags = 1 << 8, .isfloating = 0, .monitor_number = -1 },
+};
 
 /* layout(s) */
 static const int mfact = 55; /* factor of master area size [5..95] [0.05..0.95] */
@@ -202,6 +205,13 @@ static const Key surf_mode_keys[] = {
     {      0, XK_p, spawn_surf, {.v = "/dev/null"} },
 };
 
+static Mode mode_info[] = {
+    [ModeNormal]      = { .name = NULL, },
+    [ModeQuit]        = { .name = "Quit?" },
+    [ModeBrowser]     = { .name = "Browser", },
+    [ModeSurfBrowser] = { .name = "Surf", },
+};
+
 static const Array keys[] = {
     [ModeNormal]      = { (void*)normal_mode_keys,  ArrayLength(normal_mode_keys) },
     [ModeQuit]        = { (void*)quit_mode_keys,    ArrayLength(quit_mode_keys) },
@@ -0,0 +1,124 @@
+/* See LICENSE file for copyright and license details. */
+
+/* Shared between dwm and the hot-reloadable configuration module
+ * (config_module.c, built as dwm-config.so). dwm dlopens the module at
+ * startup and again on SIGHUP; the module hands over its key, button, tag
+ * and mode tables through ConfigTables. The command functions the tables
+ * bind to live in the dwm binary and are exported to the module by linking
+ * dwm with -rdynamic. Requires <X11/Xlib.h>. */
+
+#define ArrayLength(X) (sizeof(X) / sizeof((X)[0]))
+
+enum { SchemeNorm, SchemeSel, SchemeBar, SchemeAppLaunch }; /* color schemes */
+enum { ClkTagBar, ClkStatusText, ClkWinTitle,
+       ClkClientWin, ClkRootWin, ClkLast }; /* clicks */
+
+typedef struct Array Array;
+struct Array {
+    void* content;
+    int length;
+};
+
+enum {
+    ModeNormal,
+    ModeQuit,
+    ModeBrowser,
+    ModeSurfBrowser,
+};
+
+typedef struct Mode Mode;
+struct Mode {
+    char* name;
+};
+
+typedef union ActionDetails ActionDetails;
+union ActionDetails {
+    int i;
+    unsigned int ui;
+    float f;
+    const void *v;
+};
+typedef void Action(const ActionDetails *arg);
+
+typedef struct Button Button;
+struct Button {
+    unsigned int click;
+    unsigned int mask;
+    unsigned int button;
+    Action *func;
+    const ActionDetails arg;
+};
+
+typedef struct Key Key;
+struct Key {
+    unsigned int mod;
+    KeySym keysym;
+    Action *func;
+    const ActionDetails arg;
+};
+
+typedef struct Layout Layout;
+struct Layout {
+    void (*arrange)(int monitor_index);
+};
+
+typedef struct Rule Rule;
+struct Rule {
+    const char *class;
+    const char *instance;
+    const char *title;
+    unsigned int tags;
+    int isfloating;
+    int monitor_number;
+};
+
+// Everything dwm dispatches through at runtime, so a module reload swaps
+// bindings without touching a single client. keys and mode_info are both
+// indexed by mode and must have num_modes entries, ModeNormal first.
+typedef struct ConfigTables ConfigTables;
+struct ConfigTables {
+    const char **tags;     int num_tags;    // 1..31 tags
+    const Array *keys;     int num_modes;
+    const Mode *mode_info;
+    const Button *buttons; int num_buttons;
+    const Rule *rules;     int num_rules;
+};
+
+// The module exports exactly one symbol, "dwm_config", with this signature.
+// The returned tables must stay valid until the module is dlclosed.
+typedef const ConfigTables *ConfigEntryPoint(void);
+
+// Layouts (defined in dwm.c)
+void monocle(int monitor_index);
+void tile(int monitor_index);
+
+// Commands (defined in dwm.c)
+void do_nothing(const ActionDetails *arg);
+void focusmon(const ActionDetails *arg);
+void focusstack(const ActionDetails *arg);
+void killclient(const ActionDetails *arg);
+void movemouse(const ActionDetails *arg);
+void quit(const ActionDetails *arg);
+void resizemouse(const ActionDetails *arg);
+void toggle_layout(const ActionDetails *arg);
+void setmfact(const ActionDetails *arg);
+void sigstatusbar(const ActionDetails *arg);
+void spawn_action(const ActionDetails *arg);
+void spawn_dmenu(const ActionDetails *unused);
+void spawn_brave(const ActionDetails *arg);
+void spawn_firefox(const ActionDetails *arg);
+void spawn_surf(const ActionDetails *arg);
+void tag(const ActionDetails *arg);
+void tagmon(const ActionDetails *arg);
+void togglefloating(const ActionDetails *arg);
+void toggletag(const ActionDetails *arg);
+void toggleview(const ActionDetails *arg);
+void resize_window(const ActionDetails *arg);
+void move_vert(const ActionDetails *arg);
+void move_horiz(const ActionDetails *arg);
+void change_window_aspect_ratio(const ActionDetails *arg);
+void view(const ActionDetails *arg);
+void make_main_client(const ActionDetails *arg);
+
+void push_mode_action(const ActionDetails* arg);
+void pop_mode_action(const ActionDetails* arg);
@@ -0,0 +1,35 @@
+/* See LICENSE file for copyright and license details. */
+
+/* Hot-reloadable configuration module, built as dwm-config.so. dwm dlopens
+ * it at startup and re-dlopens it on SIGHUP, so a binding tweak is
+ * `make dwm-config.so install` plus `pkill -HUP dwm` instead of restarting
+ * dwm and re-managing every client. The command functions referenced by the
+ * tables resolve against the running dwm binary (linked with -rdynamic); if
+ * this module fails to load or validate, dwm keeps its compiled-in copy of
+ * the same tables as fallback. */
+
+#include <X11/keysym.h>
+#include <X11/Xlib.h>
+#include <X11/XF86keysym.h>
+#include <X11/Xft/Xft.h>
+
+#include "drw.h"
+#include "config_api.h"
+
+#include "config.h"
+
+const ConfigTables *dwm_config(void) {
+    static const ConfigTables tables = {
+        .tags        = tags,
+        .num_tags    = ArrayLength(tags),
+        .keys        = keys,
+        .num_modes   = ArrayLength(keys),
+        .mode_info   = mode_info,
+        .buttons     = buttons,
+        .num_buttons = ArrayLength(buttons),
+        .rules       = rules,
+        .num_rules   = ArrayLength(rules),
+    };
+
+    return &tables;
+}
@@ -11,6 +11,76 @@
 #define UTF_INVALID 0xFFFD
 #define UTF_SIZ     4
 
+/* Cached text extents: the bar measures the same tag labels, mode names and
+ * status text on every redraw, so memoize string -> pixel width instead of
+ * re-running the UTF-8 decode + XftTextExtentsUtf8 path each time. The cache
+ * is direct mapped (a collision just overwrites the slot) and is cleared when
+ * the fontset changes. Strings too long for a slot bypass the cache. */
+#define EXTENT_CACHE_SLOTS   128 /* must be a power of two */
+#define EXTENT_CACHE_MAX_LEN 256
+
+typedef struct ExtentCacheEntry ExtentCacheEntry;
+struct ExtentCacheEntry {
+    char text[EXTENT_CACHE_MAX_LEN];
+    unsigned int width;
+    int is_valid;
+};
+
+static ExtentCacheEntry extent_cache[EXTENT_CACHE_SLOTS];
+
+static void extent_cache_clear(void) {
+    for (int i = 0; i < EXTENT_CACHE_SLOTS; ++i)
+        extent_cache[i].is_valid = 0;
+}
+
+/* Glyph-to-font cache: which font in the set renders a codepoint. Resolving
+ * this cold means XftCharExists per font and, on a miss, a full fontconfig
+ * match — per character, per draw call. ASCII gets a flat array; everything
+ * else (the status bar icons live here) a direct-mapped table. A codepoint no
+ * font covers is cached against the first font, which draws the same
+ * missing-glyph box the cold path would settle on. Cleared with the extent
+ * cache when the fontset changes. */
+#define GLYPH_CACHE_SLOTS 256 /* must be a power of two */
+
+typedef struct GlyphCacheEntry GlyphCacheEntry;
+struct GlyphCacheEntry {
+    long codepoint;
+    Fnt *font;
+};
+
+static Fnt *ascii_font_cache[128];
+static GlyphCacheEntry glyph_cache[GLYPH_CACHE_SLOTS];
+
+static void glyph_cache_clear(void) {
+    memset(ascii_font_cache, 0, sizeof(ascii_font_cache));
+    memset(glyph_cache, 0, sizeof(glyph_cache));
+}
+
+static Fnt *glyph_cache_lookup(long codepoint) {
+    if (Between(codepoint, 0, 127))
+        return ascii_font_cache[codepoint];
+
+    GlyphCacheEntry *entry = &glyph_cache[((unsigned long)codepoint * 2654435761UL) & (GLYPH_CACHE_SLOTS - 1)];
+    return entry->codepoint == codepoint ? entry->font : NULL;
+}
+
+static void glyph_cache_store(long codepoint, Fnt *font) {
+    if (Between(codepoint, 0, 127)) {
+        ascii_font_cache[codepoint] = font;
+    } else {
+        GlyphCacheEntry *entry = &glyph_cache[((unsigned long)codepoint * 2654435761UL) & (GLYPH_CACHE_SLOTS - 1)];
+        entry->codepoint = codepoint;
+        entry->font = font;
+    }
+}
+
+static unsigned long text_hash(const char *text) {
+    unsigned long hash = 2166136261UL; /* FNV-1a */
+    for (; *text; ++text)
+        hash = (hash ^ (unsigned char)*text) * 16777619UL;
+    return hash;
+}
+
 static const unsigned char utfbyte[UTF_SIZ + 1] = {     0x80,    0,  0xC0,   0xE0,     0xF0 };
 static const unsigned char utfmask[UTF_SIZ + 1] = {     0xC0, 0x80,  0xE0,   0xF0,     0xF8 };
 static const          long  utfmin[UTF_SIZ + 1] = {        0,    0,  0x80,  0x800,  0x10000 };
@@ -67,25 +137,31 @@ void drw_init(Drw* drw, Display *display, int screen, Window root, unsigned int
     drw->root     = root;
     drw->width    = width;
     drw->height   = height;
-    drw->drawable = XCreatePixmap(display, root, height, height, DefaultDepth(display, screen));
+    drw->drawable = None;
     drw->gc       = XCreateGC(display, root, 0, NULL);
     XSetLineAttributes(display, drw->gc, 1, LineSolid, CapButt, JoinMiter);
 }
 
-void drw_resize(Drw *drw, unsigned int width, unsigned int height) {
-    drw->width  = width;
-    drw->height = height;
+void drw_clean(Drw *drw) {
+    XFreeGC(drw->display, drw->gc);
+    drw_fontset_free(drw->fonts);
+}
 
-    if (drw->drawable)
-        XFreePixmap(drw->display, drw->drawable);
+/* Per-output back buffers: each caller-owned pixmap keeps its pixels between
+ * draws, so outputs can be re-rendered independently of each other. */
+Drawable drw_create_buffer(Drw *drw, unsigned int width, unsigned int height) {
+    return XCreatePixmap(drw->display, drw->root, width, height, DefaultDepth(drw->display, drw->screen));
+}
 
-    drw->drawable = XCreatePixmap(drw->display, drw->root, width, height, DefaultDepth(drw->display, drw->screen));
+void drw_free_buffer(Drw *drw, Drawable buffer) {
+    if (buffer)
+        XFreePixmap(drw->display, buffer);
 }
 
-void drw_clean(Drw *drw) {
-    XFreePixmap(drw->display, drw->drawable);
-    XFreeGC(drw->display, drw->gc);
-    drw_fontset_free(drw->fonts);
+void drw_select_buffer(Drw *drw, Drawable buffer, unsigned int width, unsigned int height) {
+    drw->drawable = buffer;
+    drw->width = width;
+    drw->height = height;
 }
 
 /* This function is an implementation detail. Library users should use
@@ -169,6 +245,8 @@ Fnt* drw_fontset_create(Drw* drw, const char *fonts[], size_t fontcount) {
             ret = cur;
         }
     }
+    extent_cache_clear();
+    glyph_cache_clear();
     return (drw->fonts = ret);
 }
 
@@ -241,19 +319,33 @@ int drw_text(Drw *drw, int x, int y, unsigned int start_width, unsigned int heig
         Fnt *nextfont = NULL;
         while (*text) {
             utf8charlen = utf8decode(text, &utf8codepoint, UTF_SIZ);
-            for (Fnt *curfont = drw->fonts; curfont; curfont = curfont->next) {
-                charexists = charexists || XftCharExists(drw->display, curfont->xfont, utf8codepoint);
-                if (charexists) {
-                    if (curfont == usedfont) {
-                        utf8strlen += utf8charlen;
-                        text += utf8charlen;
-                    } else {
-                        nextfont = curfont;
+
+            Fnt *codepoint_font = glyph_cache_lookup(utf8codepoint);
+            if (!codepoint_font) {
+                for (Fnt *curfont = drw->fonts; curfont; curfont = curfont->next) {
+                    if (XftCharExists(drw->display, curfont->xfont, utf8codepoint)) {
+                        codepoint_font = curfont;
+                        glyph_cache_store(utf8codepoint, codepoint_font);
+                        break;
                     }
-                    break;
                 }
             }
 
+            if (codepoint_font) {
+                charexists = 1;
+                if (codepoint_font == usedfont) {
+                    utf8strlen += utf8charlen;
+                    text += utf8charlen;
+                } else {
+                    nextfont = codepoint_font;
+                }
+            } else if (charexists) {
+                /* forced after a failed fallback: consume the glyph with the
+                 * current (first) font, which renders the missing box */
+                utf8strlen += utf8charlen;
+                text += utf8charlen;
+            }
+
             if (!charexists || nextfont)
                 break;
             else
@@ -324,7 +416,12 @@ int drw_text(Drw *drw, int x, int y, unsigned int start_width, unsigned int heig
                 } else {
                     xfont_free(usedfont);
                     usedfont = drw->fonts;
+                    /* nothing renders this codepoint; remember that so the
+                     * next draw doesn't re-run fontconfig for it */
+                    glyph_cache_store(utf8codepoint, drw->fonts);
                 }
+            } else {
+                glyph_cache_store(utf8codepoint, drw->fonts);
             }
         }
     }
@@ -337,14 +434,26 @@ int drw_text(Drw *drw, int x, int y, unsigned int start_width, unsigned int heig
 
 void drw_map(Drw *drw, Window win, int x, int y, unsigned int width, unsigned int height) {
     XCopyArea(drw->display, drw->drawable, win, drw->gc, x, y, width, height, x, y);
-    XSync(drw->display, False);
+    // push the copy out without waiting for the server to finish it
+    XFlush(drw->display);
 }
 
 unsigned int drw_fontset_getwidth(Drw *drw, const char *text) {
-    if (!drw->fonts)
+    if (!drw->fonts || !text)
         return 0;
 
-    return drw_text(drw, 0, 0, 0, 0, NULL, 0, text, 0);
+    if (strlen(text) >= EXTENT_CACHE_MAX_LEN)
+        return drw_text(drw, 0, 0, 0, 0, NULL, 0, text, 0);
+
+    ExtentCacheEntry *entry = &extent_cache[text_hash(text) & (EXTENT_CACHE_SLOTS - 1)];
+    if (entry->is_valid && !strcmp(entry->text, text))
+        return entry->width;
+
+    entry->width = drw_text(drw, 0, 0, 0, 0, NULL, 0, text, 0);
+    strcpy(entry->text, text);
+    entry->is_valid = 1;
+
+    return entry->width;
 }
 
 void drw_font_getexts(Fnt *font, const char *text, unsigned int len, unsigned int *width, unsigned int *height) {
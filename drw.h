@@ -18,11 +18,11 @@ enum { ColFg, ColBg, ColBorder }; /* Color scheme index */
 
 typedef struct Drw Drw;
 struct Drw {
-	unsigned int width, height;
+	unsigned int width, height; /* of the currently selected buffer */
 	Display *display;
 	int screen;
 	Window root;
-	Drawable drawable;
+	Drawable drawable; /* currently selected buffer, owned by the caller */
 	GC gc;
 	// XftColor *scheme;
 	Fnt *fonts;
@@ -37,10 +37,14 @@ struct ColorSet {
 
 static const int numColorsInSet = sizeof(ColorSet) / sizeof(const char*);
 
-/* Drawable abstraction */
+/* Drawable abstraction. Drw does not own a pixmap itself: callers create one
+ * persistent buffer per output (drw_create_buffer), select it before drawing
+ * and free it when the output goes away. */
 void drw_init(Drw *drw, Display *display, int screen, Window win, unsigned int w, unsigned int h);
-void drw_resize(Drw *drw, unsigned int w, unsigned int h);
 void drw_clean(Drw *drw);
+Drawable drw_create_buffer(Drw *drw, unsigned int w, unsigned int h);
+void drw_free_buffer(Drw *drw, Drawable buffer);
+void drw_select_buffer(Drw *drw, Drawable buffer, unsigned int w, unsigned int h);
 
 /* Fnt abstraction */
 Fnt *drw_fontset_create(Drw* drw, const char *fonts[], size_t fontcount);
@@ -51,13 +51,17 @@
  *    - If the library is recompiled and placed into a known location then it should be reloaded
  */
 
+#include <dlfcn.h>
 #include <errno.h>
 #include <locale.h>
+#include <poll.h>
 #include <signal.h>
+#include <spawn.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/types.h>
@@ -79,107 +83,94 @@
 #define global static
 
 #include "drw.h"
+#include "pool.h"
 #include "util.h"
+#include "config_api.h"
 
 /* macros */
 #define ButtonMask                 (ButtonPressMask|ButtonReleaseMask)
 #define CleanMask(mask)            (mask & ~(numlockmask|LockMask) & (ShiftMask|ControlMask|Mod1Mask|Mod2Mask|Mod3Mask|Mod4Mask|Mod5Mask))
 #define IsVisible(Client)          (Client->tags & all_monitors[Client->monitor].selected_tags)
-#define ArrayLength(X)             (sizeof(X) / sizeof((X)[0]))
 #define MouseMask                  (ButtonMask|PointerMotionMask)
 #define GappedClientWidth(Client)  ((Client)->width + 2 * (Client)->border_width + gap_size)
 #define GappedClientHeight(Client) ((Client)->height + 2 * (Client)->border_width + gap_size)
-#define TagMask                    ((1 << ArrayLength(tags)) - 1)
+#define TagMask                    ((1u << config->num_tags) - 1)
 #define TextWidth(X)               (drw_fontset_getwidth(&drw, (X)) + lrpad)
+#define NoClient                   (-1) // "NULL" for indices into all_clients
 
 /* enums */
 enum { CurNormal, CurResize, CurMove, CurLast }; /* cursor */
-enum { SchemeNorm, SchemeSel, SchemeBar, SchemeAppLaunch }; /* color schemes */
 enum { NetSupported, NetWMName, NetWMState, NetWMCheck,
        NetWMFullscreen, NetActiveWindow, NetWMWindowType,
        NetWMWindowTypeDialog, NetClientList, NetLast }; /* EWMH atoms */
 enum { WMProtocols, WMDelete, WMState, WMTakeFocus, WMLast }; /* default atoms */
-enum { ClkTagBar, ClkStatusText, ClkWinTitle,
-       ClkClientWin, ClkRootWin, ClkLast }; /* clicks */
-
-typedef struct Array Array;
-struct Array {
-    void* content;
-    int length;
-};
-
-enum {
-    ModeNormal,
-    ModeQuit,
-    ModeBrowser,
-    ModeSurfBrowser,
-};
-
-typedef struct Mode Mode;
-struct Mode {
-    char* name;
-};
-
-
-typedef union ActionDetails ActionDetails;
-union ActionDetails {
-    int i;
-    unsigned int ui;
-    float f;
-    const void *v;
-};
-typedef void Action(const ActionDetails *arg);
-
-typedef struct Button Button;
-struct Button {
-    unsigned int click;
-    unsigned int mask;
-    unsigned int button;
-    Action *func;
-    const ActionDetails arg;
-};
-
-typedef struct Key Key;
-struct Key {
-    unsigned int mod;
-    KeySym keysym;
-    Action *func;
-    const ActionDetails arg;
-};
 
 typedef struct Monitor Monitor;
 typedef struct Client Client;
 struct Client {
-    char name[256];
-    float min_aspect, max_aspect;
     int x, y, width, height;
     int oldx, oldy, old_width, old_height;
 
-    int base_width, base_height;
-    int inc_width, inc_height;
-    int max_width, max_height;
-    int min_width, min_height;
-
     int border_width, old_border_width;
+    int configured_border_width; // border last sent to the server, which may
+                                 // differ from border_width (monocle drops it)
     unsigned int tags;
     // struct {
         // flags
+        unsigned char is_valid: 1;
         unsigned char isfixed: 1;
         unsigned char isfloating: 1;
         unsigned char isurgent: 1;
         unsigned char isfullscreen: 1;
         unsigned char neverfocus: 1;
+        unsigned char supports_take_focus: 1; // cached from WM_PROTOCOLS
+        unsigned char supports_delete: 1;     // cached from WM_PROTOCOLS
+        unsigned char size_hints_valid: 1;    // WM_NORMAL_HINTS fetched since last change
+        unsigned char counted: 1;             // included in its monitor's occupancy counts
     // };
     int oldstate;
-    Client *next;
-    Client *next_in_stack;
+    int next;          // index into all_clients array
+    int next_in_stack; // index into all_clients array
     int monitor; // index into all_monitors array
+    int client_list_position; // slot in net_client_list, for O(1) removal
     Window window;
 };
 
-typedef struct Layout Layout;
-struct Layout {
-    void (*arrange)(int monitor_index);
+// The cold half of a client: the title and the size hints are only read on a
+// property change or a floating resize, so they live in a side table parallel
+// to all_clients and keep the hot records above within a couple of cache
+// lines for the layout and occupancy loops. Titles are spans in a shared
+// growable arena rather than a fixed 256-byte buffer per client;
+// name_capacity == 0 means the client has no title yet.
+typedef struct ClientCold ClientCold;
+struct ClientCold {
+    int name_offset;   // into title_arena
+    int name_capacity; // bytes reserved at name_offset
+
+    float min_aspect, max_aspect;
+    int base_width, base_height;
+    int inc_width, inc_height;
+    int max_width, max_height;
+    int min_width, min_height;
+};
+
+// What the bar showed the last time drawbar() ran, so redraws can skip (or
+// re-render only) the segments that actually changed.
+typedef struct BarState BarState;
+struct BarState {
+    char status[256];
+    char title[256];
+    unsigned int occupied, urgent, selected_tags;
+    int mode;
+    int title_is_floating, title_is_fixed;
+    int has_status;
+    int tags_end_x;
+    int status_start_x;
+    int window_width;
+    int is_valid;
+    // cumulative right edge of every tag cell (undrawn tags repeat the
+    // previous edge), so buttonpress() can hit-test without re-measuring
+    int tag_end_x[32];
 };
 
 struct Monitor {
@@ -195,62 +186,33 @@ struct Monitor {
     unsigned int selected_tags;   // bit mask to show selected tags
     unsigned int selected_layout; // index into layouts array
 
+    // Per-tag occupancy, kept incrementally by occupancy_add()/remove() so
+    // the bar and tag-switch paths read a precomputed word instead of
+    // walking the client list.
+    unsigned int occupied_tags; // tags with at least one client
+    unsigned int urgent_tags;   // tags with at least one urgent client
+    int tag_counts[32];         // clients per tag
+    int tag_urgent_counts[32];  // urgent clients per tag
+
     // int num_clients;
 
-    Client *clients;
-    Client *selected_client;
-    Client *stack;
+    int clients;         // index into all_clients array
+    int selected_client; // index into all_clients array
+    int stack;           // index into all_clients array
     Window barwin;
+    Drawable bar_buffer;  // persistent back buffer for barwin
+    int bar_buffer_width; // width bar_buffer was created with
+    BarState bar_state;
+    int bar_needs_redraw;
 };
 
-// typedef struct Rule Rule;
-// struct Rule {
-//     const char *class;
-//     const char *instance;
-//     const char *title;
-//     unsigned int tags;
-//     int isfloating;
-//     int monitor_number;
-// };
-
 fn inline void _unused(void* x, ...){}
 #define unused(...) _unused((void*) __VA_ARGS__)
 
-// Layouts
-fn void monocle(int monitor_index);
-fn void tile(int monitor_index);
+// Layout and command prototypes live in config_api.h: they have external
+// linkage so the dlopened config module can bind to them.
 
-// Commands
-fn void do_nothing(const ActionDetails *arg);
-fn void focusmon(const ActionDetails *arg);
-fn void focusstack(const ActionDetails *arg);
-fn void killclient(const ActionDetails *arg);
-fn void movemouse(const ActionDetails *arg);
-fn void quit(const ActionDetails *arg);
-fn void resizemouse(const ActionDetails *arg);
-fn void toggle_layout(const ActionDetails *arg);
-fn void setmfact(const ActionDetails *arg);
-fn void sigstatusbar(const ActionDetails *arg);
-fn void spawn_action(const ActionDetails *arg);
-fn void spawn_dmenu(const ActionDetails *unused);
-fn void spawn_brave(const ActionDetails *arg);
-fn void spawn_firefox(const ActionDetails *arg);
-fn void spawn_surf(const ActionDetails *arg);
-fn void tag(const ActionDetails *arg);
-fn void tagmon(const ActionDetails *arg);
-fn void togglefloating(const ActionDetails *arg);
-fn void toggletag(const ActionDetails *arg);
-fn void toggleview(const ActionDetails *arg);
-fn void resize_window(const ActionDetails *arg);
-fn void move_vert(const ActionDetails *arg);
-fn void move_horiz(const ActionDetails *arg);
-fn void change_window_aspect_ratio(const ActionDetails *arg);
-fn void view(const ActionDetails *arg);
-fn void make_main_client(const ActionDetails *arg);
-
-fn void push_mode_action(const ActionDetails* arg);
-fn void pop_mode_action(const ActionDetails* arg);
-// fn void reset_mode_action(const ActionDetails* arg);
+fn void updatesizehints(Client *client);
 
 /* Variables */
 global const char broken[] = "broken";
@@ -270,18 +232,39 @@ global int global_running = 1;
 global Cur cursor[CurLast];
 global Display *global_display;
 global Drw drw;
+global Pool monitor_pool;
 global int monitor_capacity; // capacity of all_monitors array
 global Monitor *all_monitors; // , *selected_monitor;
 global int selected_monitor;
-global Window root, wmcheckwin;
-
-global Mode mode_info[] = {
-    [ModeNormal]      = { .name = NULL, },
-    [ModeQuit]        = { .name = "Quit?" },
-    [ModeBrowser]     = { .name = "Browser", },
-    [ModeSurfBrowser] = { .name = "Surf", },
+global Pool client_pool;
+global int client_capacity; // capacity of all_clients array
+global Client *all_clients;
+global ClientCold *all_clients_cold; // same capacity and indices as all_clients
+
+global char *title_arena;
+global int title_arena_size;
+global int title_arena_used;
+
+// Spans abandoned by outgrown or destroyed titles, one free list per 64-byte
+// size class so they get handed out again instead of leaking for the life of
+// the process; a free span stores the next free offset of its class in its
+// first bytes. Offsets are kept plus one so the zero-initialized lists read
+// as empty. updatetitle() caps titles at 256 bytes, so four classes cover
+// every span we create; anything larger simply isn't recycled.
+#define MaxTitleSpanClasses 4
+global int title_free_spans[MaxTitleSpanClasses];
+
+typedef struct WindowMapEntry WindowMapEntry;
+struct WindowMapEntry {
+    Window window;
+    int client; // index into all_clients array, NoClient means the slot is empty
 };
 
+global WindowMapEntry *window_map; // Window -> client index hash table
+global int window_map_capacity;    // always a power of two
+global int window_map_count;
+global Window root, wmcheckwin;
+
 // Current mode tracking: I doubt that I will have more than 8 modes stacked
 global int mode_stack[8];
 global int mode_stack_top;
@@ -289,49 +272,360 @@ global int mode_stack_top;
 /* configuration, allows nested code to access above variables */
 #include "config.h"
 
+// The live dispatch tables. config points at the compiled-in config.h copy
+// until load_config_module() swaps in the tables from the dlopened module;
+// it falls back here whenever the module fails to load or validate.
+global const ConfigTables builtin_config = {
+    .tags        = tags,
+    .num_tags    = ArrayLength(tags),
+    .keys        = keys,
+    .num_modes   = ArrayLength(keys),
+    .mode_info   = mode_info,
+    .buttons     = buttons,
+    .num_buttons = ArrayLength(buttons),
+    .rules       = rules,
+    .num_rules   = ArrayLength(rules),
+};
+global const ConfigTables *config = &builtin_config;
+
 global XftColor *scheme_color_buffer;
 global XftColor *scheme[ArrayLength(colors)];
 
 /* compile-time check if all tags fit into an unsigned int bit array. */
 struct NumTags { char limitexceeded[ArrayLength(tags) > 31 ? -1 : 1]; };
 
+// Hot-path tracing. Everything is statically sized like the mode stack:
+// recording a span is a clock read, a ring slot write and a histogram
+// increment. SIGUSR1 asks the main loop to dump the state to a file.
+enum {
+    TraceArrange, TraceDrawBar, TraceManage, TraceUnmanage, TraceRestack,
+    TraceButtonPress, TraceKeyPress, TraceConfigureRequest, TraceMapRequest,
+    TraceMotionNotify, TracePropertyNotify, TraceOtherEvent, TraceLast
+};
+
+global const char *trace_names[TraceLast] = {
+    [TraceArrange]          = "arrange",
+    [TraceDrawBar]          = "drawbar",
+    [TraceManage]           = "manage",
+    [TraceUnmanage]         = "unmanage",
+    [TraceRestack]          = "restack",
+    [TraceButtonPress]      = "buttonpress",
+    [TraceKeyPress]         = "keypress",
+    [TraceConfigureRequest] = "configurerequest",
+    [TraceMapRequest]       = "maprequest",
+    [TraceMotionNotify]     = "motionnotify",
+    [TracePropertyNotify]   = "propertynotify",
+    [TraceOtherEvent]       = "other-event",
+};
+
+typedef struct TraceRecord TraceRecord;
+struct TraceRecord {
+    unsigned int id;
+    unsigned long long start_ns; // CLOCK_MONOTONIC
+    unsigned int duration_ns;
+};
+
+#define TraceRingSize 4096 // power of two
+global TraceRecord trace_ring[TraceRingSize];
+global unsigned int trace_ring_head;
+
+// log2 buckets: bucket i counts spans with duration in [2^i, 2^(i+1)) ns
+#define TraceHistogramBuckets 32
+global unsigned int trace_histogram[TraceLast][TraceHistogramBuckets];
+global volatile sig_atomic_t trace_dump_requested;
+
+fn unsigned long long trace_clock(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+fn void trace_end(unsigned int id, unsigned long long start_ns) {
+    unsigned long long duration = trace_clock() - start_ns;
+    TraceRecord *record = &trace_ring[trace_ring_head++ & (TraceRingSize - 1)];
+
+    record->id = id;
+    record->start_ns = start_ns;
+    record->duration_ns = duration > ~0u ? ~0u : (unsigned int)duration;
+
+    unsigned int bucket = 0;
+    while (duration > 1 && bucket < TraceHistogramBuckets - 1) {
+        duration >>= 1;
+        ++bucket;
+    }
+    ++trace_histogram[id][bucket];
+}
+
+fn void trace_sigusr1(int unused) {
+    trace_dump_requested = 1;
+}
+
+fn void trace_dump(void) {
+    trace_dump_requested = 0;
+
+    FILE *file = fopen("/tmp/dwm-trace.log", "w");
+    if (!file)
+        return;
+
+    fprintf(file, "latency histograms (lower bucket bound in ns):\n");
+    for (unsigned int id = 0; id < TraceLast; ++id) {
+        unsigned int total = 0;
+        for (unsigned int bucket = 0; bucket < TraceHistogramBuckets; ++bucket)
+            total += trace_histogram[id][bucket];
+        if (total == 0)
+            continue;
+
+        fprintf(file, "%s (%u samples):\n", trace_names[id], total);
+        for (unsigned int bucket = 0; bucket < TraceHistogramBuckets; ++bucket) {
+            if (trace_histogram[id][bucket])
+                fprintf(file, "  %10llu: %u\n", 1ull << bucket, trace_histogram[id][bucket]);
+        }
+    }
+
+    fprintf(file, "\nrecent spans (oldest first):\n");
+    for (unsigned int i = 0; i < TraceRingSize; ++i) {
+        TraceRecord *record = &trace_ring[(trace_ring_head + i) & (TraceRingSize - 1)];
+        if (record->start_ns == 0)
+            continue;
+        fprintf(file, "%llu %s %uns\n", record->start_ns, trace_names[record->id], record->duration_ns);
+    }
+
+    fclose(file);
+}
+
 /* function implementations */
-// fn void applyrules(Client *client) {
-    // XClassHint ch = { NULL, NULL };
+
+// Client store: clients live in one contiguous slab array and are referred to
+// by index. The per-monitor lists are still lists, but they are index chains
+// threaded through the slab, so walking them stays inside one allocation.
+// Allocation goes through the free-list pool (pool.c), shared with monitors.
+fn Client *get_client(int client_index) {
+    return client_index != NoClient ? &all_clients[client_index] : NULL;
+}
+
+fn int client_index(Client *client) {
+    return client ? (int)(client - all_clients) : NoClient;
+}
+
+fn ClientCold *client_cold(Client *client) {
+    return &all_clients_cold[client_index(client)];
+}
+
+fn const char *client_name(Client *client) {
+    ClientCold *cold = client_cold(client);
+    return cold->name_capacity ? &title_arena[cold->name_offset] : "";
+}
+
+fn void release_title_span(int offset, int capacity) {
+    int class = capacity / 64 - 1;
+    if (class < 0 || class >= MaxTitleSpanClasses)
+        return;
+    *(int *)&title_arena[offset] = title_free_spans[class];
+    title_free_spans[class] = offset + 1;
+}
+
+fn void set_client_name(Client *client, const char *name) {
+    ClientCold *cold = client_cold(client);
+    int length = strlen(name) + 1;
+
+    if (cold->name_capacity < length) {
+        // round the span up so later title changes usually fit in place;
+        // prefer a recycled span of the right class over growing the arena
+        int capacity = (length + 63) & ~63;
+        int class = capacity / 64 - 1;
+        release_title_span(cold->name_offset, cold->name_capacity);
+        if (class < MaxTitleSpanClasses && title_free_spans[class]) {
+            cold->name_offset = title_free_spans[class] - 1;
+            title_free_spans[class] = *(int *)&title_arena[cold->name_offset];
+        } else {
+            if (title_arena_used + capacity > title_arena_size) {
+                title_arena_size = Maximum(2 * title_arena_size, title_arena_used + capacity);
+                title_arena_size = Maximum(title_arena_size, 4096);
+                if (!(title_arena = realloc(title_arena, title_arena_size)))
+                    die("fatal: could not realloc() %d bytes", title_arena_size);
+            }
+            cold->name_offset = title_arena_used;
+            title_arena_used += capacity;
+        }
+        cold->name_capacity = capacity;
+    }
+    strcpy(&title_arena[cold->name_offset], name);
+}
+
+fn int createclient(void) {
+    if (!all_clients)
+        pool_init(&client_pool, sizeof(Client), 16);
+
+    int result_index = pool_alloc(&client_pool);
+    all_clients = client_pool.items;
+    if (client_pool.capacity != client_capacity) {
+        client_capacity = client_pool.capacity;
+        if (!(all_clients_cold = realloc(all_clients_cold, client_capacity * sizeof(*all_clients_cold))))
+            die("fatal: could not realloc() %zu bytes", client_capacity * sizeof(*all_clients_cold));
+    }
+
+    Client *client = &all_clients[result_index];
+    client->next = NoClient;
+    client->next_in_stack = NoClient;
+    client->is_valid = 1;
+
+    ClientCold null_cold = {0};
+    all_clients_cold[result_index] = null_cold;
+
+    return result_index;
+}
+
+fn void destroyclient(int index) {
+    ClientCold *cold = &all_clients_cold[index];
+    if (cold->name_capacity) {
+        if (cold->name_offset + cold->name_capacity == title_arena_used)
+            title_arena_used = cold->name_offset; // give the tail span back
+        else
+            release_title_span(cold->name_offset, cold->name_capacity);
+    }
+
+    Client null_client = {0};
+    all_clients[index] = null_client;
+    pool_free_bucket(&client_pool, index);
+}
+
+// Window placement rules, precompiled by compile_rules(). Rules that give a
+// class and/or instance but no title are indexed in a small linear-probing
+// hash table and matched exactly, so the common case in applyrules() is a
+// few hash probes; rules with a title keep the stock substring semantics and
+// live on a fallback list that is scanned with strstr. Rebuilt whenever the
+// config tables are swapped.
+#define NoRule (-1)
+
+typedef struct RuleKey RuleKey;
+struct RuleKey {
+    unsigned long hash;
+    int rule; // index into config->rules, NoRule when the slot is empty
+};
+
+global RuleKey *rule_table;
+global int rule_table_capacity; // always a power of two, 0 without exact rules
+
+global int *fallback_rules; // rule indices that need substring matching
+global int num_fallback_rules;
+
+fn unsigned long rule_hash(const char *class, const char *instance) {
+    unsigned long hash = 5381;
+
+    for (; class && *class; ++class)
+        hash = hash * 33 + (unsigned char)*class;
+    hash = hash * 33 + 0xff; // keep ("ab","") distinct from ("a","b")
+    for (; instance && *instance; ++instance)
+        hash = hash * 33 + (unsigned char)*instance;
+
+    return hash;
+}
+
+fn int rule_is_exact(const Rule *rule) {
+    return (rule->class || rule->instance) && !rule->title;
+}
+
+fn void compile_rules(void) {
+    free(rule_table);
+    free(fallback_rules);
+    rule_table = NULL;
+    rule_table_capacity = 0;
+    fallback_rules = NULL;
+    num_fallback_rules = 0;
+
+    int num_exact = 0;
+    for (int i = 0; i < config->num_rules; i++)
+        if (rule_is_exact(&config->rules[i]))
+            ++num_exact;
+
+    if (num_exact > 0) {
+        rule_table_capacity = 8;
+        while (rule_table_capacity < 2 * num_exact) // at most half full
+            rule_table_capacity <<= 1;
+        rule_table = ecalloc(rule_table_capacity, sizeof(*rule_table));
+        for (int slot = 0; slot < rule_table_capacity; ++slot)
+            rule_table[slot].rule = NoRule;
+    }
+
+    if (config->num_rules > num_exact)
+        fallback_rules = ecalloc(config->num_rules - num_exact, sizeof(*fallback_rules));
+
+    for (int i = 0; i < config->num_rules; i++) {
+        const Rule *rule = &config->rules[i];
+
+        if (rule_is_exact(rule)) {
+            unsigned long hash = rule_hash(rule->class, rule->instance);
+            unsigned int slot = hash & (rule_table_capacity - 1);
+            while (rule_table[slot].rule != NoRule)
+                slot = (slot + 1) & (rule_table_capacity - 1);
+            rule_table[slot].hash = hash;
+            rule_table[slot].rule = i;
+        } else {
+            fallback_rules[num_fallback_rules++] = i;
+        }
+    }
+}
+
+fn void apply_rule(Client *client, const Rule *rule) {
+    client->isfloating = rule->isfloating;
+    client->tags |= rule->tags;
+
+    for (int monitor_index = 0; monitor_index < monitor_capacity; ++monitor_index) {
+        Monitor *monitor = &all_monitors[monitor_index];
+        if (monitor->is_valid && monitor->num == rule->monitor_number) {
+            client->monitor = monitor_index;
+            break;
+        }
+    }
+}
+
+// apply every exact rule whose key equals (class, instance); a missing rule
+// field is stored and probed as ""
+fn void match_exact_rules(Client *client, const char *class, const char *instance) {
+    unsigned long hash = rule_hash(class, instance);
+    unsigned int slot = hash & (rule_table_capacity - 1);
+
+    for (; rule_table[slot].rule != NoRule; slot = (slot + 1) & (rule_table_capacity - 1)) {
+        const Rule *rule = &config->rules[rule_table[slot].rule];
+        if (rule_table[slot].hash == hash
+            && strcmp(class, rule->class ? rule->class : "") == 0
+            && strcmp(instance, rule->instance ? rule->instance : "") == 0)
+            apply_rule(client, rule);
+    }
+}
+
+fn void applyrules(Client *client) {
+    XClassHint ch = { NULL, NULL };
 
     /* rule matching */
-    // client->isfloating = 0;
-    // client->tags = 0;
-    // XGetClassHint(global_display, client->window, &ch);
-    // const char *class    = ch.res_class ? ch.res_class : broken;
-    // const char *instance = ch.res_name  ? ch.res_name  : broken;
-
-    // for (unsigned int i = 0; i < ArrayLength(rules); i++) {
-    //     const Rule *rule = &rules[i];
-    //     if ((!rule->title || strstr(client->name, rule->title))
-    //     && (!rule->class || strstr(class, rule->class))
-    //     && (!rule->instance || strstr(instance, rule->instance))) {
-    //         client->isfloating = rule->isfloating;
-    //         client->tags |= rule->tags;
-
-    //         for(int monitor_index = 0; monitor_index < monitor_capacity; ++monitor_index) {
-    //             Monitor *monitor = &all_monitors[monitor_index];
-    //             if(monitor->is_valid && monitor->num == rule->monitor_number) {
-    //                 client->monitor = monitor_index;
-    //                 break;
-    //             }
-    //         }
-    //     }
-    // }
-
-    // if (ch.res_class)
-    //     XFree(ch.res_class);
-
-    // if (ch.res_name)
-    //     XFree(ch.res_name);
-
-    // client->tags = client->tags & TagMask ? client->tags & TagMask : all_monitors[client->monitor].selected_tags;
-// }
+    client->isfloating = 0;
+    client->tags = 0;
+    XGetClassHint(global_display, client->window, &ch); // the only class fetch per manage()
+    const char *class    = ch.res_class ? ch.res_class : broken;
+    const char *instance = ch.res_name  ? ch.res_name  : broken;
+
+    if (rule_table_capacity) {
+        match_exact_rules(client, class, instance);
+        match_exact_rules(client, class, "");
+        match_exact_rules(client, "", instance);
+    }
+
+    for (int i = 0; i < num_fallback_rules; i++) {
+        const Rule *rule = &config->rules[fallback_rules[i]];
+        if ((!rule->title || strstr(client_name(client), rule->title))
+        && (!rule->class || strstr(class, rule->class))
+        && (!rule->instance || strstr(instance, rule->instance)))
+            apply_rule(client, rule);
+    }
+
+    if (ch.res_class)
+        XFree(ch.res_class);
+
+    if (ch.res_name)
+        XFree(ch.res_name);
+
+    client->tags = client->tags & TagMask ? client->tags & TagMask : all_monitors[client->monitor].selected_tags;
+}
 
 fn int applysizehints(Client *client, int *x, int *y, int *width, int *height, int interact) {
     int baseismin;
@@ -371,39 +665,46 @@ fn int applysizehints(Client *client, int *x, int *y, int *width, int *height, i
         *width = global_bar_height;
 
     if (client->isfloating) {
+        // size hints are only consulted here, so their fetch is deferred from
+        // manage() to the first resize that actually needs them
+        if (!client->size_hints_valid)
+            updatesizehints(client);
+
+        ClientCold *cold = client_cold(client);
+
         /* see last two sentences in ICCCM 4.1.2.3 */
-        baseismin = client->base_width == client->min_width && client->base_height == client->min_height;
+        baseismin = cold->base_width == cold->min_width && cold->base_height == cold->min_height;
         if (!baseismin) { /* temporarily remove base dimensions */
-            *width  -= client->base_width;
-            *height -= client->base_height;
+            *width  -= cold->base_width;
+            *height -= cold->base_height;
         }
 
         /* adjust for aspect limits */
-        if (client->min_aspect > 0 && client->max_aspect > 0) {
-            if (client->max_aspect < (float)*width / *height)
-                *width = *height * client->max_aspect + 0.5;
-            else if (client->min_aspect < (float)*height / *width)
-                *height = *width * client->min_aspect + 0.5;
+        if (cold->min_aspect > 0 && cold->max_aspect > 0) {
+            if (cold->max_aspect < (float)*width / *height)
+                *width = *height * cold->max_aspect + 0.5;
+            else if (cold->min_aspect < (float)*height / *width)
+                *height = *width * cold->min_aspect + 0.5;
         }
 
         if (baseismin) { /* increment calculation requires this */
-            *width -= client->base_width;
-            *height -= client->base_height;
+            *width -= cold->base_width;
+            *height -= cold->base_height;
         }
 
         /* adjust for increment value */
-        if (client->inc_width)
-            *width -= *width % client->inc_width;
-        if (client->inc_height)
-            *height -= *height % client->inc_height;
+        if (cold->inc_width)
+            *width -= *width % cold->inc_width;
+        if (cold->inc_height)
+            *height -= *height % cold->inc_height;
         /* restore base dimensions */
 
-        *width = Maximum(*width + client->base_width, client->min_width);
-        *height = Maximum(*height + client->base_height, client->min_height);
-        if (client->max_width)
-            *width = Minimum(*width, client->max_width);
-        if (client->max_height)
-            *height = Minimum(*height, client->max_height);
+        *width = Maximum(*width + cold->base_width, cold->min_width);
+        *height = Maximum(*height + cold->base_height, cold->min_height);
+        if (cold->max_width)
+            *width = Minimum(*width, cold->max_width);
+        if (cold->max_height)
+            *height = Minimum(*height, cold->max_height);
     }
 
     return *x != client->x || *y != client->y || *width != client->width || *height != client->height;
@@ -416,7 +717,7 @@ fn int applysizehints(Client *client, int *x, int *y, int *width, int *height, i
 // }
 
 fn Client *nexttiled(Client *client) {
-    for (; client && (client->isfloating || !IsVisible(client)); client = client->next);
+    for (; client && (client->isfloating || !IsVisible(client)); client = get_client(client->next));
     return client;
 }
 
@@ -448,7 +749,7 @@ fn void resizeclient(Client *client, int x, int y, int width, int height) {
     wc.border_width = client->border_width;
 
     /* Get number of clients for the client's monitor */
-    for (n = 0, nbc = nexttiled(all_monitors[client->monitor].clients); nbc; nbc = nexttiled(nbc->next), n++);
+    for (n = 0, nbc = nexttiled(get_client(all_monitors[client->monitor].clients)); nbc; nbc = nexttiled(get_client(nbc->next)), n++);
 
     /* Do nothing if layout is floating */
     if (client->isfloating) {
@@ -463,15 +764,28 @@ fn void resizeclient(Client *client, int x, int y, int width, int height) {
         gapoffset = gap_size;
     }
 
-    client->oldx = client->x; client->x = wc.x = x + gapoffset;
-    client->oldy = client->y; client->y = wc.y = y + gapoffset;
-    client->old_width  = client->width; client->width = wc.width = width - gapincr;
-    client->old_height = client->height; client->height = wc.height = height - gapincr;
+    wc.x = x + gapoffset;
+    wc.y = y + gapoffset;
+    wc.width = width - gapincr;
+    wc.height = height - gapincr;
+
+    // skip the round trip (and the synthetic ConfigureNotify the app would
+    // have to chew through) when the server already has this geometry
+    if (wc.x == client->x && wc.y == client->y
+        && wc.width == client->width && wc.height == client->height
+        && wc.border_width == client->configured_border_width)
+        return;
 
+    client->oldx = client->x; client->x = wc.x;
+    client->oldy = client->y; client->y = wc.y;
+    client->old_width  = client->width; client->width = wc.width;
+    client->old_height = client->height; client->height = wc.height;
+    client->configured_border_width = wc.border_width;
 
+    // no XSync here: the requests sit in Xlib's output buffer and the whole
+    // layout pass goes out in one flush, instead of a round trip per client
     XConfigureWindow(global_display, client->window, CWX|CWY|CWWidth|CWHeight|CWBorderWidth, &wc);
     configure(client);
-    XSync(global_display, False);
 }
 
 fn void resize(Client *client, int x, int y, int width, int height, int interact) {
@@ -489,10 +803,10 @@ fn void showhide(Client *client) {
         if (client->isfloating && !client->isfullscreen) {
             resize(client, client->x, client->y, client->width, client->height, 0);
         }
-        showhide(client->next_in_stack);
+        showhide(get_client(client->next_in_stack));
     } else {
         /* hide clients bottom up */
-        showhide(client->next_in_stack);
+        showhide(get_client(client->next_in_stack));
         XMoveWindow(global_display, client->window, GappedClientWidth(client) * -2, client->y);
     }
 }
@@ -503,172 +817,454 @@ fn void drawbar(int monitor_index) {
     int text_height = global_bar_height - bottom_bar_height;
 
     Monitor *monitor = &all_monitors[monitor_index];
-    if (!monitor->showbar)
+    if (!monitor->showbar || !monitor->bar_buffer)
         return;
 
     int window_width = monitor->window_width;
+    drw_select_buffer(&drw, monitor->bar_buffer, monitor->bar_buffer_width, global_bar_height);
+    int has_status = (monitor_index == selected_monitor); /* status is only drawn on selected monitor */
+
+    // Occupancy is maintained incrementally; no client walk needed here
+    unsigned int occupied = monitor->occupied_tags;
+    unsigned int urg = monitor->urgent_tags;
+
+    int current_mode = mode_stack[mode_stack_top];
+    // Maybe this should be (current_mode != ModeNormal)
+    const char *current_mode_name = config->mode_info[current_mode].name;
+    Client *selected_client = get_client(monitor->selected_client);
+    const char *title = "";
+    int title_is_floating = 0, title_is_fixed = 0;
+    if (!current_mode_name && selected_client) {
+        title = client_name(selected_client);
+        title_is_floating = selected_client->isfloating;
+        title_is_fixed = selected_client->isfixed;
+    }
+
+    // Damage tracking: diff against what this bar showed last time so a
+    // status tick only repaints the status segment, a focus change only the
+    // title, and so on. Each monitor renders into its own persistent buffer,
+    // so the cached pixels survive redraws of the other bars.
+    BarState *state = &monitor->bar_state;
+    int cache_usable = state->is_valid
+        && state->window_width == window_width;
+    int full_redraw = !cache_usable;
+
+    int status_dirty = full_redraw
+        || has_status != state->has_status
+        || (has_status && strcmp(status_text, state->status) != 0);
+    int tags_dirty = full_redraw
+        || occupied != state->occupied
+        || urg != state->urgent
+        || monitor->selected_tags != state->selected_tags;
+    int title_dirty = full_redraw
+        || current_mode != state->mode
+        || strcmp(title, state->title) != 0
+        || title_is_floating != state->title_is_floating
+        || title_is_fixed != state->title_is_fixed;
+
+    int old_tags_end_x = state->tags_end_x;
+    int old_status_start_x = state->status_start_x;
+
+    if (has_status)
+        status_width = TextWidth(status_text) - lrpad + 2;
+    int status_start_x = window_width - status_width;
+    if (!full_redraw && status_start_x != old_status_start_x) {
+        status_dirty = 1;
+        title_dirty = 1;
+    }
+
+    int tags_end_x = old_tags_end_x;
+    if (tags_dirty) {
+        tags_end_x = 0;
+        for (int i = 0; i < config->num_tags; i++) {
+            int tag_is_selected = monitor->selected_tags & (1 << i);
+            if (occupied & (1 << i) || tag_is_selected)
+                tags_end_x += TextWidth(config->tags[i]);
+            state->tag_end_x[i] = tags_end_x;
+        }
 
-    drw_rect(&drw, 0, 0, window_width, bar_height, scheme[SchemeNorm], 1, 1);
+        if (!full_redraw && tags_end_x != old_tags_end_x)
+            title_dirty = 1;
+    }
 
-    /* draw status first so it can be overdrawn by tags later */
-    if (monitor_index == selected_monitor) {
-        /* status is only drawn on selected monitor */
-
-        // char *s, *text;
-        // char ch;
-        // for (text = s = status_text; *s; s++) {
-        //     if ((unsigned char)(*s) < ' ') {
-        //         ch = *s;
-        //         *s = '\0';
-        //         status_width += TextWidth(text) - lrpad;
-        //         *s = ch;
-        //         text = s + 1;
-        //     }
-        // }
+    if (!status_dirty && !tags_dirty && !title_dirty)
+        return;
 
-        status_width = TextWidth(status_text) - lrpad + 2;
-        drw_text(&drw, window_width - status_width, 0, status_width, text_height, scheme[SchemeNorm], 0, status_text, 0);
-    }
+    if (full_redraw)
+        drw_rect(&drw, 0, 0, window_width, bar_height, scheme[SchemeNorm], 1, 1);
 
-    // Create occupancy mask
-    unsigned int occupied = 0, urg = 0;
-    for (Client* client = monitor->clients; client; client = client->next) {
-        occupied |= client->tags;
-        if (client->isurgent)
-            urg |= client->tags;
+    /* draw status first so it can be overdrawn by tags later */
+    int status_map_from = status_start_x;
+    if (status_dirty) {
+        if (!full_redraw) {
+            status_map_from = Minimum(status_start_x, old_status_start_x);
+            drw_rect(&drw, status_map_from, 0, window_width - status_map_from, bar_height, scheme[SchemeNorm], 1, 1);
+        }
+        if (has_status)
+            drw_text(&drw, status_start_x, 0, status_width, text_height, scheme[SchemeNorm], 0, status_text, 0);
     }
 
     // Draw tags
-    int x = 0;
-    for (unsigned int i = 0; i < ArrayLength(tags); i++) {
-        int tag_is_selected = monitor->selected_tags & (1 << i);
-        if (occupied & (1 << i) || tag_is_selected) {
-            int text_width = TextWidth(tags[i]);
-            drw_text(&drw, x, 0, text_width, text_height, scheme[tag_is_selected ? SchemeSel : SchemeNorm], lrpad / 2, tags[i], urg & (1 << i));
-            if(tag_is_selected) {
-                drw_rect(&drw, x, bar_height - bottom_bar_height, text_width, bottom_bar_height, scheme[SchemeBar], 1, 0);
+    int tags_map_to = tags_end_x;
+    if (tags_dirty) {
+        if (!full_redraw) {
+            tags_map_to = Maximum(tags_end_x, old_tags_end_x);
+            drw_rect(&drw, 0, 0, tags_map_to, bar_height, scheme[SchemeNorm], 1, 1);
+        }
+
+        int x = 0;
+        for (int i = 0; i < config->num_tags; i++) {
+            int tag_is_selected = monitor->selected_tags & (1 << i);
+            if (occupied & (1 << i) || tag_is_selected) {
+                int text_width = TextWidth(config->tags[i]);
+                drw_text(&drw, x, 0, text_width, text_height, scheme[tag_is_selected ? SchemeSel : SchemeNorm], lrpad / 2, config->tags[i], urg & (1 << i));
+                if(tag_is_selected) {
+                    drw_rect(&drw, x, bar_height - bottom_bar_height, text_width, bottom_bar_height, scheme[SchemeBar], 1, 0);
+                }
+                x += text_width;
             }
-            x += text_width;
         }
     }
 
     // Draw things after tags (current client name, mode, etc.)
-    int width = window_width - status_width - x;
-    if (width > bar_height) {
-        int current_mode = mode_stack[mode_stack_top];
-
-        // Maybe this should be (current_mode != ModeNormal)
-        const char *current_mode_name = mode_info[current_mode].name;
-        if (current_mode_name) {
-            int text_width = TextWidth(current_mode_name);
-            drw_text(&drw, x, 0, width, text_height, scheme[SchemeAppLaunch], lrpad / 2, current_mode_name, 0);
-            x += text_width;
-
-            drw_rect(&drw, x, 0, width, bar_height, scheme[SchemeNorm], 1, 1);
-        } else if (monitor->selected_client) {
-            drw_text(&drw, x, 0, width, text_height, scheme[SchemeNorm], lrpad / 2, monitor->selected_client->name, 0);
-            if (monitor->selected_client->isfloating) {
-                // Box to indicate floating window
-                int boxw = drw.fonts->height / 6 + 2;
-                int boxs = drw.fonts->height / 9;
-                drw_rect(&drw, x + boxs, boxs, boxw, boxw, scheme[SchemeNorm], monitor->selected_client->isfixed, 0);
+    int title_map_from = Minimum(tags_end_x, old_tags_end_x);
+    int title_map_to = Maximum(status_start_x, old_status_start_x);
+    if (title_dirty) {
+        int x = tags_end_x;
+        int width = window_width - status_width - x;
+
+        if (!full_redraw)
+            drw_rect(&drw, x, 0, Maximum(width, 0), bar_height, scheme[SchemeNorm], 1, 1);
+
+        if (width > bar_height) {
+            if (current_mode_name) {
+                int text_width = TextWidth(current_mode_name);
+                drw_text(&drw, x, 0, width, text_height, scheme[SchemeAppLaunch], lrpad / 2, current_mode_name, 0);
+                x += text_width;
+
+                drw_rect(&drw, x, 0, width, bar_height, scheme[SchemeNorm], 1, 1);
+            } else if (selected_client) {
+                drw_text(&drw, x, 0, width, text_height, scheme[SchemeNorm], lrpad / 2, title, 0);
+                if (title_is_floating) {
+                    // Box to indicate floating window
+                    int boxw = drw.fonts->height / 6 + 2;
+                    int boxs = drw.fonts->height / 9;
+                    drw_rect(&drw, x + boxs, boxs, boxw, boxw, scheme[SchemeNorm], title_is_fixed, 0);
+                }
+            // } else {
+            //     drw_rect(&drw, x, 0, width, bar_height, scheme[SchemeNorm], 1, 1);
             }
-        // } else {
-        //     drw_rect(&drw, x, 0, width, bar_height, scheme[SchemeNorm], 1, 1);
         }
     }
 
-    drw_map(&drw, monitor->barwin, 0, 0, window_width, bar_height);
+    // Remember what was drawn, then copy out only the dirty segments
+    strncpy(state->status, status_text, sizeof(state->status) - 1);
+    state->status[sizeof(state->status) - 1] = '\0';
+    strncpy(state->title, title, sizeof(state->title) - 1);
+    state->title[sizeof(state->title) - 1] = '\0';
+    state->occupied = occupied;
+    state->urgent = urg;
+    state->selected_tags = monitor->selected_tags;
+    state->mode = current_mode;
+    state->title_is_floating = title_is_floating;
+    state->title_is_fixed = title_is_fixed;
+    state->has_status = has_status;
+    state->tags_end_x = tags_end_x;
+    state->status_start_x = status_start_x;
+    state->window_width = window_width;
+    state->is_valid = 1;
+
+    if (full_redraw) {
+        drw_map(&drw, monitor->barwin, 0, 0, window_width, bar_height);
+    } else {
+        if (tags_dirty)
+            drw_map(&drw, monitor->barwin, 0, 0, tags_map_to, bar_height);
+        if (title_dirty)
+            drw_map(&drw, monitor->barwin, title_map_from, 0, Maximum(title_map_to - title_map_from, 0), bar_height);
+        if (status_dirty)
+            drw_map(&drw, monitor->barwin, status_map_from, 0, window_width - status_map_from, bar_height);
+    }
+}
+
+// Bar redraws are requested, not painted on the spot: a burst of events can
+// mark the same bar dirty many times, but it is only rendered once the event
+// queue has drained (flush_bar_redraws in the event loops).
+fn void request_bar_redraw(int monitor_index) {
+    all_monitors[monitor_index].bar_needs_redraw = 1;
 }
 
 fn void drawbars(void) {
     for (int monitor_index = 0; monitor_index < monitor_capacity; ++monitor_index) {
         if(all_monitors[monitor_index].is_valid) {
+            request_bar_redraw(monitor_index);
+        }
+    }
+}
+
+fn void flush_bar_redraws(void) {
+    for (int monitor_index = 0; monitor_index < monitor_capacity; ++monitor_index) {
+        Monitor *monitor = &all_monitors[monitor_index];
+        if(monitor->is_valid && monitor->bar_needs_redraw) {
+            monitor->bar_needs_redraw = 0;
+            unsigned long long trace_start = trace_clock();
             drawbar(monitor_index);
+            trace_end(TraceDrawBar, trace_start);
         }
     }
 }
 
+// EnterNotify events whose serial is at or below this were caused by our own
+// restacking, not by the user moving the pointer, and must not steal focus
+global unsigned long enter_notify_ignore_serial;
+
 fn void restack(int monitor_index) {
     Client *client;
-    XEvent ev;
-    XWindowChanges wc;
+    unsigned long long trace_start = trace_clock();
 
-    drawbar(monitor_index);
+    request_bar_redraw(monitor_index);
     Monitor *monitor = &all_monitors[monitor_index];
-    if (!monitor->selected_client)
+    Client *selected_client = get_client(monitor->selected_client);
+    if (!selected_client) {
+        trace_end(TraceRestack, trace_start);
         return;
+    }
 
-    if (monitor->selected_client->isfloating) {
-        XRaiseWindow(global_display, monitor->selected_client->window);
+    if (selected_client->isfloating) {
+        XRaiseWindow(global_display, selected_client->window);
     }
 
-    wc.stack_mode = Below;
-    wc.sibling = monitor->barwin;
-    for (client = monitor->stack; client; client = client->next_in_stack) {
+    // collect the visible tiled clients and submit the whole stacking order
+    // below the bar in one batch instead of one XConfigureWindow per client
+    Window order[client_capacity + 1];
+    unsigned int count = 0;
+
+    order[count++] = monitor->barwin;
+    for (client = get_client(monitor->stack); client; client = get_client(client->next_in_stack)) {
         if (!client->isfloating && IsVisible(client)) {
-            XConfigureWindow(global_display, client->window, CWSibling|CWStackMode, &wc);
-            wc.sibling = client->window;
+            order[count++] = client->window;
         }
     }
-    XSync(global_display, False);
-    while (XCheckMaskEvent(global_display, EnterWindowMask, &ev));
+    if (count > 1)
+        XRestackWindows(global_display, order, count);
+
+    // instead of a blocking XSync plus an event drain, remember the request
+    // serial; the EnterNotify handler drops anything at or below it. The
+    // no-op request matters: an event carries the serial of the last request
+    // the server processed, so a genuine crossing with no intervening
+    // requests would otherwise tie the restack's serial and be discarded
+    // (focus-follows-mouse going dead until the next keystroke). With the
+    // no-op queued, any crossing after the restack outranks the boundary.
+    enter_notify_ignore_serial = NextRequest(global_display) - 1;
+    XNoOp(global_display);
+    trace_end(TraceRestack, trace_start);
 }
 
 fn void arrange(int monitor_index) {
+    unsigned long long trace_start = trace_clock();
     if (Between(monitor_index, 0, monitor_capacity - 1)) {
         Monitor* monitor = &all_monitors[monitor_index];
-        showhide(monitor->stack);
+        showhide(get_client(monitor->stack));
         layouts[monitor->selected_layout].arrange(monitor_index);
         restack(monitor_index);
     } else {
         for(int monitor_index = 0; monitor_index < monitor_capacity; ++monitor_index) {
             Monitor* monitor = &all_monitors[monitor_index];
             if(monitor->is_valid) {
-                showhide(monitor->stack);
+                showhide(get_client(monitor->stack));
                 layouts[monitor->selected_layout].arrange(monitor_index);
                 restack(monitor_index);
             }
         }
     }
+    trace_end(TraceArrange, trace_start);
 }
 
 fn int next_valid_monitor(int start_index) {
+    if (!Between(start_index, 0, monitor_capacity - 1))
+        start_index = 0;
+
     int result = start_index;
-    for (;result != start_index; ++result) {
-        if(result == monitor_capacity) {
+    do {
+        if (all_monitors[result].is_valid)
+            return result;
+
+        ++result;
+        if (result == monitor_capacity)
             result = 0;
-        }
+    } while (result != start_index);
 
-        if(all_monitors[result].is_valid) {
-            break;
-        }
+    return start_index;
+}
+
+// Occupancy bookkeeping. Mutating client->tags, client->isurgent or the
+// monitor membership of an attached client must happen between an
+// occupancy_remove() and an occupancy_add(); the counted flag makes the pair
+// safe for clients that are not attached yet.
+fn void occupancy_add(Client *client) {
+    Monitor *monitor = &all_monitors[client->monitor];
+
+    if (client->counted)
+        return;
+    client->counted = 1;
+
+    for (int t = 0; t < config->num_tags; ++t) {
+        if (!(client->tags & (1u << t)))
+            continue;
+        if (++monitor->tag_counts[t] == 1)
+            monitor->occupied_tags |= 1u << t;
+        if (client->isurgent && ++monitor->tag_urgent_counts[t] == 1)
+            monitor->urgent_tags |= 1u << t;
+    }
+}
+
+fn void occupancy_remove(Client *client) {
+    Monitor *monitor = &all_monitors[client->monitor];
+
+    if (!client->counted)
+        return;
+    client->counted = 0;
+
+    for (int t = 0; t < config->num_tags; ++t) {
+        if (!(client->tags & (1u << t)))
+            continue;
+        if (--monitor->tag_counts[t] == 0)
+            monitor->occupied_tags &= ~(1u << t);
+        if (client->isurgent && --monitor->tag_urgent_counts[t] == 0)
+            monitor->urgent_tags &= ~(1u << t);
     }
-    return result;
 }
 
 fn void attach(Client *client) {
     Monitor* monitor = &all_monitors[client->monitor];
     client->next = monitor->clients;
-    monitor->clients = client;
+    monitor->clients = client_index(client);
+    occupancy_add(client);
 }
 
 fn void attachstack(Client *client) {
     Monitor* monitor = &all_monitors[client->monitor];
     client->next_in_stack = monitor->stack;
-    monitor->stack = client;
+    monitor->stack = client_index(client);
+}
+
+// Window -> client lookup: every arm of the event loop starts with a
+// wintoclient() call, so the mapping is kept in a linear-probing hash table
+// maintained by manage()/unmanage() instead of scanning the client list.
+fn unsigned int window_map_slot(Window window) {
+    // window ids are mostly sequential, the multiply spreads them out
+    unsigned long hash = (unsigned long)window * 2654435761UL;
+    return (unsigned int)(hash & (window_map_capacity - 1));
+}
+
+fn void window_map_insert(Window window, int client) {
+    if (!window_map) {
+        window_map_capacity = 64;
+        window_map = ecalloc(window_map_capacity, sizeof(WindowMapEntry));
+        for (int i = 0; i < window_map_capacity; ++i)
+            window_map[i].client = NoClient;
+    } else if (4 * (window_map_count + 1) >= 3 * window_map_capacity) {
+        // keep the table at most 3/4 full so probe runs stay short
+        WindowMapEntry *old_map = window_map;
+        int old_capacity = window_map_capacity;
+
+        window_map_capacity = old_capacity << 1;
+        window_map_count = 0;
+        window_map = ecalloc(window_map_capacity, sizeof(WindowMapEntry));
+        for (int i = 0; i < window_map_capacity; ++i)
+            window_map[i].client = NoClient;
+
+        for (int i = 0; i < old_capacity; ++i)
+            if (old_map[i].client != NoClient)
+                window_map_insert(old_map[i].window, old_map[i].client);
+
+        free(old_map);
+    }
+
+    unsigned int slot = window_map_slot(window);
+    while (window_map[slot].client != NoClient && window_map[slot].window != window)
+        slot = (slot + 1) & (window_map_capacity - 1);
+
+    if (window_map[slot].client == NoClient)
+        ++window_map_count;
+
+    window_map[slot].window = window;
+    window_map[slot].client = client;
+}
+
+fn void window_map_remove(Window window) {
+    if (!window_map)
+        return;
+
+    unsigned int slot = window_map_slot(window);
+    while (window_map[slot].client != NoClient && window_map[slot].window != window)
+        slot = (slot + 1) & (window_map_capacity - 1);
+
+    if (window_map[slot].client == NoClient)
+        return;
+
+    window_map[slot].client = NoClient;
+    --window_map_count;
+
+    // re-insert the probe run that follows so lookups never hit a hole
+    slot = (slot + 1) & (window_map_capacity - 1);
+    while (window_map[slot].client != NoClient) {
+        WindowMapEntry entry = window_map[slot];
+        window_map[slot].client = NoClient;
+        --window_map_count;
+        window_map_insert(entry.window, entry.client);
+        slot = (slot + 1) & (window_map_capacity - 1);
+    }
 }
 
 fn Client *wintoclient(Window window) {
-    for(int monitor_index = 0; monitor_index < monitor_capacity; ++monitor_index) {
-        Monitor* monitor = &all_monitors[monitor_index];
-        if(monitor->is_valid) {
-            for (Client *client = monitor->clients; client; client = client->next)
-                if (client->window == window)
-                    return client;
-        }
+    if (!window_map)
+        return NULL;
+
+    unsigned int slot = window_map_slot(window);
+    while (window_map[slot].client != NoClient && window_map[slot].window != window)
+        slot = (slot + 1) & (window_map_capacity - 1);
+
+    return get_client(window_map[slot].client);
+}
+
+// Contiguous mirror of every managed window, published as _NET_CLIENT_LIST
+// with one PropModeReplace instead of re-appending each client on unmanage.
+global Window *net_client_list;
+global int net_client_list_count;
+global int net_client_list_capacity;
+
+fn void publish_client_list(void) {
+    XChangeProperty(global_display, root, netatom[NetClientList], XA_WINDOW, 32,
+                    PropModeReplace, (unsigned char *)net_client_list, net_client_list_count);
+}
+
+fn void client_list_add(Client *client) {
+    if (net_client_list_count == net_client_list_capacity) {
+        net_client_list_capacity = net_client_list_capacity > 0 ? net_client_list_capacity << 1 : 16;
+        net_client_list = realloc(net_client_list, net_client_list_capacity * sizeof(Window));
+        if (!net_client_list)
+            die("fatal: could not realloc() client list");
     }
-    return NULL;
+
+    client->client_list_position = net_client_list_count;
+    net_client_list[net_client_list_count++] = client->window;
+    publish_client_list();
+}
+
+fn void client_list_remove(Client *client) {
+    int position = client->client_list_position;
+
+    // swap the last window into the vacated slot
+    --net_client_list_count;
+    if (position != net_client_list_count) {
+        Window moved = net_client_list[net_client_list_count];
+        Client *moved_client = wintoclient(moved);
+
+        net_client_list[position] = moved;
+        if (moved_client)
+            moved_client->client_list_position = position;
+    }
+    publish_client_list();
 }
 
 fn int getrootptr(int *x, int *y) {
@@ -679,9 +1275,26 @@ fn int getrootptr(int *x, int *y) {
     return XQueryPointer(global_display, root, &dummy, &dummy, x, y, &di, &di, &dui);
 }
 
+// recttomon() runs for every motion event during a drag and every pointer
+// crossing of the root window. Pointer locality means the monitor that
+// matched last time almost always matches again, so it is tested first with
+// a containment check — a fully contained rect cannot overlap any other
+// monitor more — and the area scan over all_monitors is only the fallback.
+// The check also re-validates the geometry, so the cache never needs
+// explicit invalidation when updategeom() rearranges monitors.
+global int rect_last_hit_monitor = -1;
+
 fn int recttomon(int x, int y, int width, int height) {
     int maximum_area = 0;
 
+    if (rect_last_hit_monitor >= 0 && rect_last_hit_monitor < monitor_capacity) {
+        Monitor *monitor = &all_monitors[rect_last_hit_monitor];
+        if (monitor->is_valid
+            && x >= monitor->window_x && x + width  <= monitor->window_x + monitor->window_width
+            && y >= monitor->window_y && y + height <= monitor->window_y + monitor->window_height)
+            return rect_last_hit_monitor;
+    }
+
     int result = selected_monitor;
     for (int monitor_index = 0; monitor_index < monitor_capacity; ++monitor_index) {
         Monitor *monitor = &all_monitors[monitor_index];
@@ -695,6 +1308,10 @@ fn int recttomon(int x, int y, int width, int height) {
             }
         }
     }
+
+    if (maximum_area > 0)
+        rect_last_hit_monitor = result;
+
     return result;
 }
 
@@ -717,11 +1334,18 @@ fn int wintomon(Window window) {
     return selected_monitor;
 }
 
-// 
+// numlockmask is cached: XGetModifierMapping costs a server round trip plus
+// a malloc/free, and grabbuttons() runs on every focus change. The cache is
+// only invalidated by MappingNotify, so repeat calls are free.
+global int numlockmask_valid;
+
 fn void updatenumlockmask(void) {
     unsigned int i, j;
     XModifierKeymap *modmap;
 
+    if (numlockmask_valid)
+        return;
+
     numlockmask = 0;
     modmap = XGetModifierMapping(global_display);
     for (i = 0; i < 8; i++)
@@ -730,6 +1354,7 @@ fn void updatenumlockmask(void) {
                 == XKeysymToKeycode(global_display, XK_Num_Lock))
                 numlockmask = (1 << i);
     XFreeModifiermap(modmap);
+    numlockmask_valid = 1;
 }
 
 fn void grabbuttons(Client *client, int focused) {
@@ -741,11 +1366,11 @@ fn void grabbuttons(Client *client, int focused) {
         if (!focused)
             XGrabButton(global_display, AnyButton, AnyModifier, client->window, False,
                         ButtonMask, GrabModeSync, GrabModeSync, None, None);
-        for (i = 0; i < ArrayLength(buttons); i++) {
-            if (buttons[i].click == ClkClientWin) {
+        for (i = 0; i < (unsigned int)config->num_buttons; i++) {
+            if (config->buttons[i].click == ClkClientWin) {
                 for (j = 0; j < ArrayLength(modifiers); j++) {
-                    XGrabButton(global_display, buttons[i].button,
-                                buttons[i].mask | modifiers[j],
+                    XGrabButton(global_display, config->buttons[i].button,
+                                config->buttons[i].mask | modifiers[j],
                                 client->window, False, ButtonMask,
                                 GrabModeAsync, GrabModeSync, None, None);
                 }
@@ -754,6 +1379,16 @@ fn void grabbuttons(Client *client, int focused) {
     }
 }
 
+// Key dispatch table for the current mode, rebuilt by grabkeys(). Bindings
+// are chained per keycode so the KeyPress handler resolves a keystroke with
+// one array lookup instead of scanning the whole key array with
+// XKeysymToKeycode calls inside the loop.
+#define NoKeyBinding (-1)
+global int key_dispatch_head[256]; // first binding index for a keycode, NoKeyBinding when none
+global int *key_dispatch_next;    // next binding with the same keycode
+global unsigned int *key_dispatch_mask; // cleaned modifier mask per binding
+global int key_dispatch_capacity;
+
 fn void grabkeys(void) {
     updatenumlockmask();
     {
@@ -762,14 +1397,28 @@ fn void grabkeys(void) {
         XUngrabKey(global_display, AnyKey, AnyModifier, root);
 
         int current_mode = mode_stack[mode_stack_top];
-        Key* key_array = (Key*) keys[current_mode].content;
-        int  length    = keys[current_mode].length;
-        for(unsigned int key_index = 0; key_index < length; ++key_index) {
+        Key* key_array = (Key*) config->keys[current_mode].content;
+        int  length    = config->keys[current_mode].length;
+
+        if (length > key_dispatch_capacity) {
+            free(key_dispatch_next);
+            free(key_dispatch_mask);
+            key_dispatch_next = ecalloc(length, sizeof(*key_dispatch_next));
+            key_dispatch_mask = ecalloc(length, sizeof(*key_dispatch_mask));
+            key_dispatch_capacity = length;
+        }
+        for (unsigned int code = 0; code < ArrayLength(key_dispatch_head); ++code)
+            key_dispatch_head[code] = NoKeyBinding;
+
+        for(int key_index = 0; key_index < length; ++key_index) {
             KeyCode code = XKeysymToKeycode(global_display, key_array[key_index].keysym);
             if (code != 0) {
                 for (unsigned int mod_index = 0; mod_index < ArrayLength(modifiers); mod_index++) {
                     XGrabKey(global_display, code, key_array[key_index].mod | modifiers[mod_index], root, True, GrabModeAsync, GrabModeAsync);
                 }
+                key_dispatch_mask[key_index] = CleanMask(key_array[key_index].mod);
+                key_dispatch_next[key_index] = key_dispatch_head[code];
+                key_dispatch_head[code] = key_index;
             }
         }
     }
@@ -780,7 +1429,9 @@ fn void grabkeys(void) {
 fn void seturgent(Client *client, int urg) {
     XWMHints *wmh;
 
+    occupancy_remove(client);
     client->isurgent = urg;
+    occupancy_add(client);
     if (!(wmh = XGetWMHints(global_display, client->window)))
         return;
     wmh->flags = urg ? (wmh->flags | XUrgencyHint) : (wmh->flags & ~XUrgencyHint);
@@ -789,28 +1440,48 @@ fn void seturgent(Client *client, int urg) {
 }
 
 fn void detachstack(Client *client) {
-    Client **tc, *t;
+    Monitor *monitor = &all_monitors[client->monitor];
+    int index = client_index(client);
 
-    for (tc = &all_monitors[client->monitor].stack; *tc && *tc != client; tc = &(*tc)->next_in_stack);
-    *tc = client->next_in_stack;
+    int *link = &monitor->stack;
+    for (; *link != NoClient && *link != index; link = &all_clients[*link].next_in_stack);
+    *link = client->next_in_stack;
 
-    if (client == all_monitors[client->monitor].selected_client) {
-        for (t = all_monitors[client->monitor].stack; t && !IsVisible(t); t = t->next_in_stack);
-        all_monitors[client->monitor].selected_client = t;
+    if (index == monitor->selected_client) {
+        Client *t;
+        for (t = get_client(monitor->stack); t && !IsVisible(t); t = get_client(t->next_in_stack));
+        monitor->selected_client = client_index(t);
     }
 }
 
-fn int sendevent(Client *client, Atom proto) {
+// Fetch WM_PROTOCOLS once and keep the bits we care about on the client, so
+// sendevent() doesn't pay a synchronous property fetch on every focus change.
+fn void updatewmprotocols(Client *client) {
     int n;
     Atom *protocols;
-    int exists = 0;
-    XEvent ev;
 
+    client->supports_take_focus = 0;
+    client->supports_delete = 0;
     if (XGetWMProtocols(global_display, client->window, &protocols, &n)) {
-        while (!exists && n--)
-            exists = protocols[n] == proto;
+        while (n--) {
+            if (protocols[n] == wmatom[WMTakeFocus])
+                client->supports_take_focus = 1;
+            else if (protocols[n] == wmatom[WMDelete])
+                client->supports_delete = 1;
+        }
         XFree(protocols);
     }
+}
+
+fn int sendevent(Client *client, Atom proto) {
+    int exists = 0;
+    XEvent ev;
+
+    if (proto == wmatom[WMTakeFocus])
+        exists = client->supports_take_focus;
+    else if (proto == wmatom[WMDelete])
+        exists = client->supports_delete;
+
     if (exists) {
         ev.type = ClientMessage;
         ev.xclient.window = client->window;
@@ -847,10 +1518,10 @@ fn void unfocus(Client *client, int setfocus) {
 
 fn void focus(Client *client) {
     if (!client || !IsVisible(client))
-        for (client = all_monitors[selected_monitor].stack; client && !IsVisible(client); client = client->next_in_stack) {
+        for (client = get_client(all_monitors[selected_monitor].stack); client && !IsVisible(client); client = get_client(client->next_in_stack)) {
         }
 
-    Client *selected_client = all_monitors[selected_monitor].selected_client;
+    Client *selected_client = get_client(all_monitors[selected_monitor].selected_client);
     if (selected_client && selected_client != client)
         unfocus(selected_client, 0);
 
@@ -870,10 +1541,41 @@ fn void focus(Client *client) {
         XSetInputFocus(global_display, root, RevertToPointerRoot, CurrentTime);
         XDeleteProperty(global_display, root, netatom[NetActiveWindow]);
     }
-    all_monitors[selected_monitor].selected_client = client;
+    all_monitors[selected_monitor].selected_client = client_index(client);
     drawbars();
 }
 
+// buttons from the config tables grouped by click region, so buttonpress()
+// only scans the bindings that can match instead of the whole array
+global int button_bucket_first[ClkLast];
+global int button_bucket_count[ClkLast];
+global int *button_order;
+global int button_order_capacity;
+
+fn void init_button_buckets(void) {
+    int counts[ClkLast] = {0};
+    int fill[ClkLast];
+    int start = 0;
+
+    if (config->num_buttons > button_order_capacity) {
+        free(button_order);
+        button_order = ecalloc(config->num_buttons, sizeof(*button_order));
+        button_order_capacity = config->num_buttons;
+    }
+
+    for (int i = 0; i < config->num_buttons; i++)
+        ++counts[config->buttons[i].click];
+
+    for (int click = 0; click < ClkLast; click++) {
+        button_bucket_first[click] = fill[click] = start;
+        button_bucket_count[click] = counts[click];
+        start += counts[click];
+    }
+
+    for (int i = 0; i < config->num_buttons; i++)
+        button_order[fill[config->buttons[i].click]++] = i;
+}
+
 fn void buttonpress(XEvent *event) {
     ActionDetails arg = {0};
     Client *client;
@@ -882,7 +1584,7 @@ fn void buttonpress(XEvent *event) {
     /* focus monitor if necessary */
     int monitor_index = wintomon(ev->window);
     if (monitor_index >= 0 && monitor_index != selected_monitor) {
-        unfocus(all_monitors[selected_monitor].selected_client, 1);
+        unfocus(get_client(all_monitors[selected_monitor].selected_client), 1);
         selected_monitor = monitor_index;
         focus(NULL);
     }
@@ -890,25 +1592,24 @@ fn void buttonpress(XEvent *event) {
     unsigned int click = ClkRootWin;
     Monitor *monitor = &all_monitors[selected_monitor];
     if (ev->window == monitor->barwin) {
-        unsigned int i = 0, x = 0;
-
-        int occupied = 0;
-        for (client = all_monitors[monitor_index].clients; client; client = client->next) {
-            occupied |= client->tags;
-        }
-
-        do {
-            int tag_mask = (1 << i);
-            if (occupied & tag_mask || tag_mask & monitor->selected_tags & tag_mask) { 
-                x += TextWidth(tags[i]);
+        // hit-test against the segment extents drawbar() recorded instead of
+        // re-measuring every tag label on each click
+        BarState *state = &monitor->bar_state;
+
+        if (state->is_valid && ev->x < state->tags_end_x) {
+            // binary search the cumulative cell edges for the clicked tag
+            unsigned int lo = 0, hi = config->num_tags - 1;
+            while (lo < hi) {
+                unsigned int mid = (lo + hi) / 2;
+                if (ev->x < state->tag_end_x[mid])
+                    hi = mid;
+                else
+                    lo = mid + 1;
             }
-        } while (ev->x >= x && ++i < ArrayLength(tags));
-
-        if (i < ArrayLength(tags)) {
             click = ClkTagBar;
-            arg.ui = 1 << i;
-        } else if (ev->x > all_monitors[selected_monitor].window_width - status_width) {
-            x = all_monitors[selected_monitor].window_width - status_width;
+            arg.ui = 1 << lo;
+        } else if (state->is_valid && state->has_status && ev->x > state->status_start_x) {
+            int x = state->status_start_x;
             click = ClkStatusText;
             statussig = 0;
             char* s;
@@ -934,12 +1635,12 @@ fn void buttonpress(XEvent *event) {
         click = ClkClientWin;
     }
 
-    for (int i = 0; i < ArrayLength(buttons); i++) {
-        if (click == buttons[i].click &&
-            buttons[i].func &&
-            buttons[i].button == ev->button &&
-            CleanMask(buttons[i].mask) == CleanMask(ev->state)) {
-            buttons[i].func((click == ClkTagBar && buttons[i].arg.i == 0) ? &arg : &buttons[i].arg);
+    for (int i = button_bucket_first[click], end = i + button_bucket_count[click]; i < end; i++) {
+        const Button *button = &config->buttons[button_order[i]];
+        if (button->func &&
+            button->button == ev->button &&
+            CleanMask(button->mask) == CleanMask(ev->state)) {
+            button->func((click == ClkTagBar && button->arg.i == 0) ? &arg : &button->arg);
             break;
         }
     }
@@ -951,65 +1652,42 @@ fn void cleanup_monitor(int monitor_index) {
 
     XUnmapWindow(global_display, monitor->barwin);
     XDestroyWindow(global_display, monitor->barwin);
+    drw_free_buffer(&drw, monitor->bar_buffer);
 
     Monitor null_monitor = {0};
     *monitor = null_monitor;
+    pool_free_bucket(&monitor_pool, monitor_index);
 }
 
 fn int createmon(void) {
-    Monitor *monitor = NULL;
-    int result_index;
-
-    if(all_monitors) {
-        int monitor_index = 0;
-        for(; monitor_index < monitor_capacity; ++monitor_index) {
-            Monitor *current_monitor = &all_monitors[monitor_index];
-            if(!current_monitor->is_valid) {
-                monitor = current_monitor;
-                result_index = monitor_index;
-                break;
-            }
-        }
-
-        if(monitor_index == monitor_capacity) {
-            // expand array, all monitors up to end must be valid to reach this point
-            int new_capacity = monitor_capacity << 1;
-            Monitor *new_buffer = ecalloc(new_capacity, sizeof(Monitor));
-            for(monitor_index = 0; monitor_index < monitor_capacity; ++monitor_index) {
-                new_buffer[monitor_index] = all_monitors[monitor_index];
-            }
-
-            // new monitor will be at the end of the new buffer (remember all before this are valid)
-            result_index = monitor_capacity;
-            monitor = &new_buffer[monitor_capacity];
-
-            free(all_monitors);
-            all_monitors = new_buffer;
-            monitor_capacity = new_capacity;
-        }
-
-    } else {
-        monitor_capacity = 2;
-        all_monitors = ecalloc(monitor_capacity, sizeof(Monitor));
-        monitor = all_monitors;
-        result_index = 0;
-    }
+    if (!all_monitors)
+        pool_init(&monitor_pool, sizeof(Monitor), 2);
 
+    int result_index = pool_alloc(&monitor_pool);
+    all_monitors = monitor_pool.items;
+    monitor_capacity = monitor_pool.capacity;
 
+    Monitor *monitor = &all_monitors[result_index];
     monitor->selected_tags = 1;
     monitor->mfact = mfact;
     monitor->showbar = showbar;
     monitor->topbar = topbar;
+    monitor->clients = NoClient;
+    monitor->selected_client = NoClient;
+    monitor->stack = NoClient;
     monitor->is_valid = 1;
 
     return result_index;
 }
 
 fn void detach(Client *client) {
-    Client **tc;
+    int index = client_index(client);
+
+    occupancy_remove(client);
 
-    for (tc = &all_monitors[client->monitor].clients; *tc && *tc != client; tc = &(*tc)->next);
-    *tc = client->next;
+    int *link = &all_monitors[client->monitor].clients;
+    for (; *link != NoClient && *link != index; link = &all_clients[*link].next);
+    *link = client->next;
 }
 
 fn int dirtomon(int dir) {
@@ -1048,7 +1726,7 @@ fn int dirtomon(int dir) {
 }
 
 fn void set_current_monitor(int monitor_index) {
-    unfocus(all_monitors[selected_monitor].selected_client, 0);
+    unfocus(get_client(all_monitors[selected_monitor].selected_client), 0);
     selected_monitor = monitor_index;
     focus(NULL);
 }
@@ -1068,27 +1746,24 @@ fn Atom getatomprop(Client *client, Atom prop) {
 }
 
 fn pid_t getstatusbarpid() {
-    char buf[32], *str = buf, *c;
+    char buf[32];
     FILE *fp;
 
-    if (statuspid > 0) {
-        snprintf(buf, sizeof(buf), "/proc/%u/cmdline", statuspid);
-        if ((fp = fopen(buf, "r"))) {
-            fgets(buf, sizeof(buf), fp);
-            while ((c = strchr(str, '/')))
-                str = c + 1;
-            fclose(fp);
-            if (!strcmp(str, STATUSBAR))
-                return statuspid;
-        }
-    }
+    // cheap path: the pid we spawned (or discovered earlier) is still alive,
+    // no need to fork a process-table scan on every status bar click
+    if (statuspid > 0 && kill(statuspid, 0) == 0)
+        return statuspid;
 
+    // slow path: discover the bar and cache the result for next time
     if (!(fp = popen("pgrep -o "STATUSBAR, "r")))
         return -1;
 
+    buf[0] = '\0';
     fgets(buf, sizeof(buf), fp);
     pclose(fp);
-    return strtol(buf, NULL, 10);
+
+    statuspid = strtol(buf, NULL, 10);
+    return statuspid > 0 ? statuspid : -1;
 }
 
 fn long getstate(Window window) {
@@ -1158,10 +1833,13 @@ fn int xerror(Display *display, XErrorEvent *ee) {
 }
 
 fn void updatetitle(Client *client) {
-    if (!gettextprop(client->window, netatom[NetWMName], client->name, sizeof(client->name)))
-        gettextprop(client->window, XA_WM_NAME, client->name, sizeof(client->name));
-    if (client->name[0] == '\0') /* hack to mark broken clients */
-        strcpy(client->name, broken);
+    char name[256];
+
+    if (!gettextprop(client->window, netatom[NetWMName], name, sizeof(name)))
+        gettextprop(client->window, XA_WM_NAME, name, sizeof(name));
+    if (name[0] == '\0') /* hack to mark broken clients */
+        strcpy(name, broken);
+    set_client_name(client, name);
 }
 
 fn void setfullscreen(Client *client, int fullscreen) {
@@ -1183,11 +1861,9 @@ fn void setfullscreen(Client *client, int fullscreen) {
         client->isfullscreen = 0;
         client->isfloating = client->oldstate;
         client->border_width = client->old_border_width;
-        client->x = client->oldx;
-        client->y = client->oldy;
-        client->width = client->old_width;
-        client->height = client->old_height;
-        resizeclient(client, client->x, client->y, client->width, client->height);
+        // hand resizeclient the saved geometry instead of assigning it first,
+        // so its unchanged-geometry check compares against the fullscreen size
+        resizeclient(client, client->oldx, client->oldy, client->old_width, client->old_height);
         arrange(client->monitor);
     }
 }
@@ -1205,6 +1881,7 @@ fn void updatewindowtype(Client *client) {
 fn void updatesizehints(Client *client) {
     long msize;
     XSizeHints size;
+    ClientCold *cold = client_cold(client);
 
     if (!XGetWMNormalHints(global_display, client->window, &size, &msize)) {
         /* size is uninitialized, ensure that size.flags aren't used */
@@ -1212,58 +1889,61 @@ fn void updatesizehints(Client *client) {
     }
 
     if (size.flags & PBaseSize) {
-        client->base_width = size.base_width;
-        client->base_height = size.base_height;
+        cold->base_width = size.base_width;
+        cold->base_height = size.base_height;
     } else if (size.flags & PMinSize) {
-        client->base_width = size.min_width;
-        client->base_height = size.min_height;
+        cold->base_width = size.min_width;
+        cold->base_height = size.min_height;
     } else {
-        client->base_width = client->base_height = 0;
+        cold->base_width = cold->base_height = 0;
     }
 
     if (size.flags & PResizeInc) {
-        client->inc_width = size.width_inc;
-        client->inc_height = size.height_inc;
+        cold->inc_width = size.width_inc;
+        cold->inc_height = size.height_inc;
     } else {
-        client->inc_width = client->inc_height = 0;
+        cold->inc_width = cold->inc_height = 0;
     }
 
     if (size.flags & PMaxSize) {
-        client->max_width = size.max_width;
-        client->max_height = size.max_height;
+        cold->max_width = size.max_width;
+        cold->max_height = size.max_height;
     } else {
-        client->max_width = client->max_height = 0;
+        cold->max_width = cold->max_height = 0;
     }
 
     if (size.flags & PMinSize) {
-        client->min_width = size.min_width;
-        client->min_height = size.min_height;
+        cold->min_width = size.min_width;
+        cold->min_height = size.min_height;
     } else if (size.flags & PBaseSize) {
-        client->min_width = size.base_width;
-        client->min_height = size.base_height;
+        cold->min_width = size.base_width;
+        cold->min_height = size.base_height;
     } else {
-        client->min_width = client->min_height = 0;
+        cold->min_width = cold->min_height = 0;
     }
 
     if (size.flags & PAspect) {
-        client->min_aspect = (float)size.min_aspect.y / size.min_aspect.x;
-        client->max_aspect = (float)size.max_aspect.x / size.max_aspect.y;
+        cold->min_aspect = (float)size.min_aspect.y / size.min_aspect.x;
+        cold->max_aspect = (float)size.max_aspect.x / size.max_aspect.y;
     } else {
-        client->max_aspect = client->min_aspect = 0.0;
+        cold->max_aspect = cold->min_aspect = 0.0;
     }
 
-    client->isfixed = (client->max_width && client->max_height && client->max_width == client->min_width && client->max_height == client->min_height);
+    client->isfixed = (cold->max_width && cold->max_height && cold->max_width == cold->min_width && cold->max_height == cold->min_height);
+    client->size_hints_valid = 1;
 }
 
 fn void updatewmhints(Client *client) {
     XWMHints *wmh;
 
     if((wmh = XGetWMHints(global_display, client->window)) != NULL) {
-        if(client == all_monitors[selected_monitor].selected_client && wmh->flags & XUrgencyHint) {
+        if(client_index(client) == all_monitors[selected_monitor].selected_client && wmh->flags & XUrgencyHint) {
             wmh->flags &= ~XUrgencyHint;
             XSetWMHints(global_display, client->window, wmh);
         } else {
+            occupancy_remove(client);
             client->isurgent = (wmh->flags & XUrgencyHint) ? 1 : 0;
+            occupancy_add(client);
         }
 
         if(wmh->flags & InputHint) {
@@ -1286,9 +1966,11 @@ fn void manage(Window window, XWindowAttributes *wa) {
     Client *client, *t = NULL;
     Window trans = None;
     XWindowChanges wc;
+    unsigned long long trace_start = trace_clock();
 
-    client = ecalloc(1, sizeof(Client));
+    client = &all_clients[createclient()];
     client->window = window;
+    window_map_insert(window, client_index(client));
 
     /* geometry */
     client->x      = client->oldx = wa->x;
@@ -1303,11 +1985,7 @@ fn void manage(Window window, XWindowAttributes *wa) {
         client->tags = t->tags;
     } else {
         client->monitor = selected_monitor;
-        // applyrules(client);
-        //
-        // NOTE: This was the last line of applyrules
-        int suggested_tags = client->tags & TagMask;
-        client->tags = suggested_tags ? suggested_tags : all_monitors[selected_monitor].selected_tags;
+        applyrules(client); // placement settles before the first arrange()
     }
 
     Monitor *monitor = &all_monitors[client->monitor];
@@ -1323,11 +2001,12 @@ fn void manage(Window window, XWindowAttributes *wa) {
 
     wc.border_width = client->border_width;
     XConfigureWindow(global_display, window, CWBorderWidth, &wc);
+    client->configured_border_width = wc.border_width;
     XSetWindowBorder(global_display, window, scheme[SchemeNorm][ColBorder].pixel);
     configure(client); /* propagates border_width, if size doesn't change */
     updatewindowtype(client);
-    updatesizehints(client);
     updatewmhints(client);
+    updatewmprotocols(client);
     XSelectInput(global_display, window, EnterWindowMask|FocusChangeMask|PropertyChangeMask|StructureNotifyMask);
     grabbuttons(client, 0);
 
@@ -1340,26 +2019,26 @@ fn void manage(Window window, XWindowAttributes *wa) {
     attach(client);
     attachstack(client);
 
-    XChangeProperty(global_display, root, netatom[NetClientList], XA_WINDOW, 32, PropModeAppend,
-                    (unsigned char *) &(client->window), 1);
+    client_list_add(client);
     XMoveResizeWindow(global_display, client->window, client->x + 2 * global_screen_width, client->y, client->width, client->height); /* some windows require this */
     setclientstate(client, NormalState);
 
     if (client->monitor == selected_monitor)
-        unfocus(all_monitors[selected_monitor].selected_client, 0);
+        unfocus(get_client(all_monitors[selected_monitor].selected_client), 0);
 
-    monitor->selected_client = client;
+    monitor->selected_client = client_index(client);
     arrange(client->monitor);
     XMapWindow(global_display, client->window);
     focus(NULL);
+    trace_end(TraceManage, trace_start);
 }
 
 // Layouts
-fn void monocle(int monitor_index) {
+void monocle(int monitor_index) {
     Client *client;
     Monitor* monitor = &all_monitors[monitor_index];
     // assume the monitor is valid? It wasn't checked for NULL before
-    for (client = nexttiled(monitor->clients); client; client = nexttiled(client->next)) {
+    for (client = nexttiled(get_client(monitor->clients)); client; client = nexttiled(get_client(client->next))) {
         resize(client,
                monitor->window_x,
                monitor->window_y,
@@ -1369,19 +2048,19 @@ fn void monocle(int monitor_index) {
     }
 }
 
-fn void tile(int monitor_index) {
+void tile(int monitor_index) {
     unsigned int num_clients;
     Monitor* monitor = &all_monitors[monitor_index];
-    Client *client = nexttiled(monitor->clients);
+    Client *client = nexttiled(get_client(monitor->clients));
 
 
-    for (num_clients = 0; client; client = nexttiled(client->next), num_clients++) {
+    for (num_clients = 0; client; client = nexttiled(get_client(client->next)), num_clients++) {
     }
 
     if (num_clients == 0)
         return;
 
-    client = nexttiled(monitor->clients);
+    client = nexttiled(get_client(monitor->clients));
 
     if(num_clients == 1) {
         // draw master window on the full screen, basically monocle
@@ -1404,12 +2083,12 @@ fn void tile(int monitor_index) {
                monitor->window_height - (2*client->border_width),
                0);
 
-        client = nexttiled(client->next);
+        client = nexttiled(get_client(client->next));
         master_width -= gap_size;
 
         // draw remaining windows on right
         unsigned int height = (monitor->window_height - gap_size) / (num_clients - 1);
-        for (; client != NULL; client = nexttiled(client->next)) {
+        for (; client != NULL; client = nexttiled(get_client(client->next))) {
             resize(client,
                    monitor->window_x, //  + master_width,
                    monitor->window_y + ty,
@@ -1426,7 +2105,9 @@ fn void tile(int monitor_index) {
 }
 
 fn void sendmon(Client *client, int monitor_index) {
-    if (client->monitor == monitor_index)
+    int source_monitor = client->monitor;
+
+    if (source_monitor == monitor_index)
         return;
 
     unfocus(client, 1);
@@ -1437,7 +2118,9 @@ fn void sendmon(Client *client, int monitor_index) {
     attach(client);
     attachstack(client);
     focus(NULL);
-    arrange(-1);
+    // only the two monitors involved changed; leave the rest alone
+    arrange(source_monitor);
+    arrange(monitor_index);
 }
 
 fn void pop_client(Client *client) {
@@ -1450,6 +2133,7 @@ fn void pop_client(Client *client) {
 fn void unmanage(Client *client, int destroyed) {
     int monitor = client->monitor;
     XWindowChanges wc;
+    unsigned long long trace_start = trace_clock();
 
     detach(client);
     detachstack(client);
@@ -1464,22 +2148,12 @@ fn void unmanage(Client *client, int destroyed) {
         XSetErrorHandler(xerror);
         XUngrabServer(global_display);
     }
-    free(client);
+    client_list_remove(client);
+    window_map_remove(client->window);
+    destroyclient(client_index(client));
     focus(NULL);
-
-    // update client list
-    XDeleteProperty(global_display, root, netatom[NetClientList]);
-    for (int monitor_index = 0; monitor_index < monitor_capacity; ++monitor_index) {
-        Monitor *monitor = &all_monitors[monitor_index];
-        if(monitor->is_valid) {
-            for (Client *client = monitor->clients; client; client = client->next)
-                XChangeProperty(global_display, root, netatom[NetClientList],
-                                XA_WINDOW, 32, PropModeAppend,
-                                (unsigned char *) &(client->window), 1);
-        }
-    }
-
     arrange(monitor);
+    trace_end(TraceUnmanage, trace_start);
 }
 
 fn void updatebars(void) {
@@ -1493,6 +2167,14 @@ fn void updatebars(void) {
     for (int monitor_index = 0; monitor_index < monitor_capacity; ++monitor_index) {
         Monitor *monitor = &all_monitors[monitor_index];
         if(monitor->is_valid) {
+            // (Re)size this monitor's back buffer; its old pixels are gone, so
+            // the damage-tracking state is stale too.
+            if (!monitor->bar_buffer || monitor->bar_buffer_width != monitor->window_width) {
+                drw_free_buffer(&drw, monitor->bar_buffer);
+                monitor->bar_buffer = drw_create_buffer(&drw, monitor->window_width, global_bar_height);
+                monitor->bar_buffer_width = monitor->window_width;
+                monitor->bar_state.is_valid = 0;
+            }
             if (monitor->barwin)
                 continue;
             monitor->barwin = XCreateWindow(global_display, root, monitor->window_x, monitor->bar_height, monitor->window_width, global_bar_height, 0, DefaultDepth(global_display, global_screen),
@@ -1528,12 +2210,6 @@ fn int updategeom(void) {
         XineramaScreenInfo *info = XineramaQueryScreens(global_display, &num_screens);
         XineramaScreenInfo *unique = NULL;
 
-        int monitor_count = 0;
-        for (int monitor_index = 0; monitor_index < monitor_capacity; ++monitor_index) {
-            Monitor *monitor = &all_monitors[monitor_index];
-            monitor_count += (monitor->is_valid != 0);
-        }
-
         /* only consider unique geometries as separate screens */
         unique = ecalloc(num_screens, sizeof(XineramaScreenInfo));
         for (i = 0, j = 0; i < num_screens; i++) {
@@ -1544,7 +2220,7 @@ fn int updategeom(void) {
             while (n--) {
                 if(unique[n].x_org == screen_info->x_org && unique[n].y_org  == screen_info->y_org
                    && unique[n].width == screen_info->width && unique[n].height == screen_info->height) {
-                    isuniquegeom = 1;
+                    isuniquegeom = 0;
                     break;
                 }
             }
@@ -1555,58 +2231,91 @@ fn int updategeom(void) {
         }
         XFree(info);
         num_screens = j;
-        if (monitor_count <= num_screens) { /* new monitors available */
-            for (i = 0; i < (num_screens - monitor_count); i++) {
-                createmon();
-            }
 
-            for (int i = 0, monitor_index = 0; i < num_screens;) {
-                Monitor *current_monitor = &all_monitors[monitor_index];
-
-                if(current_monitor->is_valid) {
-                    if(i >= monitor_count
-                       || unique[i].x_org  != current_monitor->screen_x
-                       || unique[i].y_org  != current_monitor->screen_y
-                       || unique[i].width  != current_monitor->screen_width
-                       || unique[i].height != current_monitor->screen_height) {
-                        dirty = 1;
-                        current_monitor->num = i;
-                        current_monitor->screen_x = current_monitor->window_x = unique[i].x_org;
-                        current_monitor->screen_y = current_monitor->window_y = unique[i].y_org;
-                        current_monitor->screen_width = current_monitor->window_width = unique[i].width;
-                        current_monitor->screen_height = current_monitor->window_height = unique[i].height;
-                        updatebarpos(monitor_index);
-                    }
-                    i++;
+        // Diff the screens against the monitors we already have instead of
+        // rebuilding the whole list. A monitor whose geometry survives the
+        // change is left alone, so docking only touches what actually moved.
+        int *claimed_by = ecalloc(num_screens, sizeof(int)); // monitor index claiming each screen
+        int *orphans = ecalloc(monitor_capacity > 0 ? monitor_capacity : 1, sizeof(int));
+        int orphan_count = 0;
+
+        for (i = 0; i < num_screens; ++i)
+            claimed_by[i] = -1;
+
+        for (int monitor_index = 0; monitor_index < monitor_capacity; ++monitor_index) {
+            Monitor *monitor = &all_monitors[monitor_index];
+            if (!monitor->is_valid)
+                continue;
+
+            int screen = -1;
+            for (i = 0; i < num_screens; ++i) {
+                if (claimed_by[i] == -1
+                    && unique[i].x_org == monitor->screen_x && unique[i].y_org == monitor->screen_y
+                    && unique[i].width == monitor->screen_width && unique[i].height == monitor->screen_height) {
+                    screen = i;
+                    break;
                 }
-                ++monitor_index;
             }
 
-        } else { /* less monitors available num_screens < monitor_count */
-            for (i = num_screens; i < monitor_count; i++) {
-                int monitor_index = monitor_capacity - 1;
-                for (; Between(monitor_index, 0, monitor_capacity - 1) && !all_monitors[monitor_index].is_valid; --monitor_index);
-
-                Monitor *monitor = &all_monitors[monitor_index];
+            if (screen >= 0) {
+                claimed_by[screen] = monitor_index;
+                monitor->num = screen;
+            } else {
+                orphans[orphan_count++] = monitor_index;
+            }
+        }
 
-                while ((client = monitor->clients)) {
-                    dirty = 1;
-                    monitor->clients = client->next;
-                    monitor->is_valid = 0;
+        // an unclaimed screen first reuses an orphaned monitor (a screen
+        // whose geometry changed in place keeps its clients), then falls
+        // back to creating a fresh one
+        for (i = 0; i < num_screens; ++i) {
+            if (claimed_by[i] != -1)
+                continue;
 
-                    detachstack(client);
-                    client->monitor = next_valid_monitor(client->monitor + 1);
-                    attach(client);
-                    attachstack(client);
-                }
+            int monitor_index;
+            if (orphan_count > 0) {
+                monitor_index = orphans[--orphan_count];
+            } else {
+                monitor_index = createmon();
+            }
 
-                if (monitor_index == selected_monitor) {
-                    selected_monitor = next_valid_monitor(0);
-                }
+            Monitor *monitor = &all_monitors[monitor_index]; // createmon may move the slab
+            dirty = 1;
+            claimed_by[i] = monitor_index;
+            monitor->num = i;
+            monitor->screen_x = monitor->window_x = unique[i].x_org;
+            monitor->screen_y = monitor->window_y = unique[i].y_org;
+            monitor->screen_width = monitor->window_width = unique[i].width;
+            monitor->screen_height = monitor->window_height = unique[i].height;
+            updatebarpos(monitor_index);
+        }
 
-                cleanup_monitor(monitor_index);
+        // whatever is left lost its screen entirely: hand its clients to the
+        // monitor showing the first screen before releasing it, so nothing
+        // becomes unreachable
+        for (i = 0; i < orphan_count; ++i) {
+            int orphan_index = orphans[i];
+            Monitor *orphan = &all_monitors[orphan_index];
+            int target = claimed_by[0];
+
+            while ((client = get_client(orphan->clients))) {
+                dirty = 1;
+                detach(client);
+                detachstack(client);
+                client->monitor = target;
+                attach(client);
+                attachstack(client);
             }
+
+            if (orphan_index == selected_monitor)
+                selected_monitor = target;
+
+            dirty = 1;
+            cleanup_monitor(orphan_index);
         }
+
+        free(orphans);
+        free(claimed_by);
         free(unique);
     } else
 #endif /* XINERAMA */
@@ -1634,26 +2343,40 @@ fn int updategeom(void) {
     return dirty;
 }
 
-fn void updatestatus(void) {
-    if (!gettextprop(root, XA_WM_NAME, status_text, sizeof(status_text))) {
-        strcpy(status_text, "dwm-"VERSION);
-        status_width = TextWidth(status_text) - lrpad + 2;
-    } else {
-        char *text, *s, ch;
-
-        status_width  = 0;
-        for (text = s = status_text; *s; s++) {
-            if ((unsigned char)(*s) < ' ') {
-                ch = *s;
-                *s = '\0';
-                status_width += TextWidth(text) - lrpad;
-                *s = ch;
-                text = s + 1;
-            }
+fn void refresh_status_width(void) {
+    char *text, *s, ch;
+
+    status_width  = 0;
+    for (text = s = status_text; *s; s++) {
+        if ((unsigned char)(*s) < ' ') {
+            ch = *s;
+            *s = '\0';
+            status_width += TextWidth(text) - lrpad;
+            *s = ch;
+            text = s + 1;
         }
-        status_width += TextWidth(text) - lrpad + 2;
     }
-    drawbar(selected_monitor);
+    status_width += TextWidth(text) - lrpad + 2;
+}
+
+// Fallback path for status set through the root window name (xsetroot); the
+// spawned status bar child writes to its pipe instead and never pays this
+// property round-trip.
+fn void updatestatus(void) {
+    char new_text[sizeof(status_text)];
+
+    if (!gettextprop(root, XA_WM_NAME, new_text, sizeof(new_text)))
+        strcpy(new_text, "dwm-"VERSION);
+
+    // Volume-OSD-style spam re-sets the same text over and over; if nothing
+    // changed, the rendered status segment in the bar buffer is still right
+    // and there is no measuring or redrawing to do.
+    if (strcmp(new_text, status_text) == 0)
+        return;
+
+    strcpy(status_text, new_text);
+    refresh_status_width();
+    request_bar_redraw(selected_monitor);
 }
 
 // Event functions
@@ -1707,15 +2430,18 @@ fn void configurerequest(XEvent *event) {
         wc.stack_mode = ev->detail;
         XConfigureWindow(global_display, ev->window, ev->value_mask, &wc);
     }
-    XSync(global_display, False);
+    XFlush(global_display);
 }
 
 fn void expose(XEvent *event) {
     int monitor_index;
     XExposeEvent *ev = &event->xexpose;
 
-    if (ev->count == 0 && (monitor_index = wintomon(ev->window)))
-        drawbar(monitor_index);
+    if (ev->count == 0 && (monitor_index = wintomon(ev->window))) {
+        // the window contents are gone, the cached bar state is not what is on screen
+        all_monitors[monitor_index].bar_state.is_valid = 0;
+        request_bar_redraw(monitor_index);
+    }
 }
 
 fn void maprequest(XEvent *event) {
@@ -1735,7 +2461,8 @@ fn void maprequest(XEvent *event) {
 // Mode control
 
 fn void push_mode(int mode_info_index) {
-    if(mode_stack_top < ArrayLength(mode_stack)) {
+    if(mode_info_index >= 0 && mode_info_index < config->num_modes
+       && mode_stack_top < ArrayLength(mode_stack)) {
         ++mode_stack_top;
         mode_stack[mode_stack_top] = mode_info_index;
         grabkeys();
@@ -1755,6 +2482,77 @@ fn void reset_mode() {
     grabkeys();
 }
 
+// Hot config reload: SIGHUP re-dlopens the config module and swaps the
+// dispatch tables in place without touching a single client. See
+// config_api.h / config_module.c; on any failure the current tables
+// (ultimately the compiled-in config.h copy) stay live.
+global void *config_module_handle;
+global volatile sig_atomic_t config_reload_requested;
+
+fn void config_sighup(int unused) {
+    config_reload_requested = 1;
+}
+
+fn void apply_config(const ConfigTables *new_config) {
+    config = new_config;
+
+    // Mode indices don't necessarily survive a table swap; this also
+    // rebuilds the key grabs and dispatch table for ModeNormal.
+    reset_mode();
+    init_button_buckets();
+    compile_rules();
+
+    for (int monitor_index = 0; monitor_index < monitor_capacity; ++monitor_index) {
+        Monitor *monitor = &all_monitors[monitor_index];
+        if (!monitor->is_valid)
+            continue;
+
+        for (Client *client = get_client(monitor->clients); client; client = get_client(client->next))
+            grabbuttons(client, monitor_index == selected_monitor
+                                && client_index(client) == monitor->selected_client);
+
+        // tag names may have changed
+        monitor->bar_state.is_valid = 0;
+        request_bar_redraw(monitor_index);
+    }
+}
+
+fn void load_config_module(void) {
+    // glibc resolves a dlopen of an already-mapped pathname to the existing
+    // link map, so the previous module must be dlclosed before the new file
+    // on disk can actually load. Drop to the compiled-in tables first:
+    // config must never point into an unmapped module, and they stay live
+    // as the fallback if the fresh load fails below.
+    if (config_module_handle) {
+        dlclose(config_module_handle);
+        config_module_handle = NULL;
+        apply_config(&builtin_config);
+    }
+
+    void *handle = dlopen(ConfigModulePath, RTLD_NOW);
+    if (!handle) {
+        fprintf(stderr, "dwm: config module: %s\n", dlerror());
+        return;
+    }
+
+    ConfigEntryPoint *entry = NULL;
+    *(void **)&entry = dlsym(handle, "dwm_config");
+
+    const ConfigTables *new_config = entry ? entry() : NULL;
+    if (!new_config
+        || !new_config->tags || new_config->num_tags < 1 || new_config->num_tags > 31
+        || !new_config->keys || new_config->num_modes < 1 || !new_config->mode_info
+        || (new_config->num_buttons > 0 && !new_config->buttons)
+        || (new_config->num_rules > 0 && !new_config->rules)) {
+        fprintf(stderr, "dwm: config module %s has no usable tables\n", ConfigModulePath);
+        dlclose(handle);
+        return;
+    }
+
+    config_module_handle = handle;
+    apply_config(new_config);
+}
+
 // Process control
 static void closepipe(int pipe[2]) {
     close(pipe[0]);
@@ -1768,8 +2566,45 @@ struct ChildProcess {
     int std_input;
 };
 
+global ChildProcess status_bar_process;
+global time_t status_bar_last_restart;
+global int status_bar_restart_pending;
+
+extern char **environ;
+
 fn ChildProcess spawn(char const **command, int from_command) {
     ChildProcess result = {0};
+
+    if (from_command) {
+        // Fire-and-forget launches (dmenu, browsers, keybound commands) need
+        // no pipes; posix_spawn avoids duplicating the page tables of a
+        // long-running dwm just to exec, which fork() pays for on every
+        // keypress-to-dmenu launch.
+        posix_spawn_file_actions_t file_actions;
+        posix_spawnattr_t attr;
+        pid_t pid;
+
+        posix_spawn_file_actions_init(&file_actions);
+        posix_spawnattr_init(&attr);
+        if (global_display)
+            posix_spawn_file_actions_addclose(&file_actions, ConnectionNumber(global_display));
+#ifdef POSIX_SPAWN_SETSID
+        posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSID);
+#endif
+        // posix_spawnp reports errors via its return value, not errno
+        int spawn_error = posix_spawnp(&pid, command[0], &file_actions, &attr, (char **)command, environ);
+        if (spawn_error == 0) {
+            result.pid = pid;
+        } else {
+            fprintf(stderr, "dwm: posix_spawn %s failed: %s\n", command[0], strerror(spawn_error));
+            result.pid = -1;
+        }
+        posix_spawnattr_destroy(&attr);
+        posix_spawn_file_actions_destroy(&file_actions);
+
+        return result;
+    }
+
     int wm_to_process[2] = {0};
     int process_to_wm[2] = {0};
 
@@ -1781,11 +2616,11 @@ fn ChildProcess spawn(char const **command, int from_command) {
         close(wm_to_process[1]);
         close(process_to_wm[0]);
 
-        if (from_command) {
-            if (global_display)
-                close(ConnectionNumber(global_display));
-            setsid();
-        }
+        // wm children talk to dwm over their stdin/stdout
+        dup2(wm_to_process[0], 0);
+        dup2(process_to_wm[1], 1);
+        close(wm_to_process[0]);
+        close(process_to_wm[1]);
         execvp(command[0], (char **)command);
         fprintf(stderr, "dwm: execvp %s", command[0]);
         perror(" failed");
@@ -1815,30 +2650,29 @@ fn void spawn_and_reset_mode(char const **arg) {
 }
 
 // Commands
-fn void do_nothing(const ActionDetails *arg) {
+void do_nothing(const ActionDetails *arg) {
     // This is just a test command
     // printf("Doing nothing...except printing\n");
 }
 
-fn void make_main_client(const ActionDetails *arg) {
-    Client *selected_client = all_monitors[selected_monitor].selected_client;
+void make_main_client(const ActionDetails *arg) {
+    Client *selected_client = get_client(all_monitors[selected_monitor].selected_client);
 
     if(selected_client && selected_client->isfloating)
         return;
 
-    if(selected_client == nexttiled(all_monitors[selected_monitor].clients))
-        if(!selected_client || !(selected_client = nexttiled(selected_client->next)))
+    if(selected_client == nexttiled(get_client(all_monitors[selected_monitor].clients)))
+        if(!selected_client || !(selected_client = nexttiled(get_client(selected_client->next))))
             return;
 
     pop_client(selected_client);
 }
 
-fn void movemouse(const ActionDetails *arg) {
+void movemouse(const ActionDetails *arg) {
     Client *client;
     XEvent ev;
-    Time lasttime = 0;
 
-    if (!(client = all_monitors[selected_monitor].selected_client))
+    if (!(client = get_client(all_monitors[selected_monitor].selected_client)))
         return;
 
     if (client->isfullscreen) /* no support moving fullscreen windows by mouse */
@@ -1855,9 +2689,14 @@ fn void movemouse(const ActionDetails *arg) {
     if (!getrootptr(&x, &y))
         return;
 
+    // manage() can grow the client slab while we handle MapRequest below, so
+    // re-derive the pointer from the index on every iteration
+    int dragged_client = client_index(client);
+    int last_nx = client->x, last_ny = client->y;
     Monitor *monitor = &all_monitors[selected_monitor];
     do {
         XMaskEvent(global_display, MouseMask|ExposureMask|SubstructureRedirectMask, &ev);
+        client = &all_clients[dragged_client];
         switch(ev.type) {
             case ConfigureRequest:
                 configurerequest(&ev);
@@ -1872,10 +2711,11 @@ fn void movemouse(const ActionDetails *arg) {
                 break;
 
             case MotionNotify:
-                if ((ev.xmotion.time - lasttime) <= (1000 / 60))
-                    continue;
+                // act on the newest queued position instead of throttling to
+                // a fixed 60 Hz; high-rate displays deliver motion faster
+                // than we can resize, and stale positions are worthless
+                while (XCheckTypedEvent(global_display, MotionNotify, &ev));
 
-                lasttime = ev.xmotion.time;
                 int nx = ocx + (ev.xmotion.x - x);
                 int ny = ocy + (ev.xmotion.y - y);
 
@@ -1892,11 +2732,18 @@ fn void movemouse(const ActionDetails *arg) {
                 if (!client->isfloating && (abs(nx - client->x) > snap || abs(ny - client->y) > snap))
                     togglefloating(NULL);
 
+                // nothing to recompute when the snapped position didn't move
+                if (nx == last_nx && ny == last_ny)
+                    break;
+                last_nx = nx;
+                last_ny = ny;
+
                 if (client->isfloating)
                     resize(client, nx, ny, client->width, client->height, 1);
 
                 break;
         }
+        flush_bar_redraws();
     } while (ev.type != ButtonRelease);
     XUngrabPointer(global_display, CurrentTime);
 
@@ -1908,17 +2755,16 @@ fn void movemouse(const ActionDetails *arg) {
     }
 }
 
-fn void quit(const ActionDetails *arg) {
+void quit(const ActionDetails *arg) {
     global_running = 0;
 }
 
-fn void resizemouse(const ActionDetails *arg) {
+void resizemouse(const ActionDetails *arg) {
     int ocx, ocy, nw, nh;
     Client *client;
     XEvent ev;
-    Time lasttime = 0;
 
-    if (!(client = all_monitors[selected_monitor].selected_client))
+    if (!(client = get_client(all_monitors[selected_monitor].selected_client)))
         return;
 
     if (client->isfullscreen) /* no support resizing fullscreen windows by mouse */
@@ -1933,10 +2779,15 @@ fn void resizemouse(const ActionDetails *arg) {
 
     XWarpPointer(global_display, None, client->window, 0, 0, 0, 0, client->width + client->border_width - 1, client->height + client->border_width - 1);
 
+    // manage() can grow the client slab while we handle MapRequest below, so
+    // re-derive the pointer from the index on every iteration
+    int dragged_client = client_index(client);
+    int last_nw = client->width, last_nh = client->height;
     Monitor *client_monitor = &all_monitors[client->monitor];
     Monitor *monitor = &all_monitors[selected_monitor];
     do {
         XMaskEvent(global_display, MouseMask|ExposureMask|SubstructureRedirectMask, &ev);
+        client = &all_clients[dragged_client];
         switch(ev.type) {
             case ConfigureRequest:
                 configurerequest(&ev);
@@ -1951,9 +2802,9 @@ fn void resizemouse(const ActionDetails *arg) {
                 break;
 
             case MotionNotify:
-                if ((ev.xmotion.time - lasttime) <= (1000 / 60))
-                    continue;
-                lasttime = ev.xmotion.time;
+                // act on the newest queued position instead of throttling to
+                // a fixed 60 Hz (see movemouse)
+                while (XCheckTypedEvent(global_display, MotionNotify, &ev));
 
                 nw = Maximum(ev.xmotion.x - ocx - 2 * client->border_width + 1, 1);
                 nh = Maximum(ev.xmotion.y - ocy - 2 * client->border_width + 1, 1);
@@ -1964,10 +2815,17 @@ fn void resizemouse(const ActionDetails *arg) {
                         togglefloating(NULL);
                 }
 
+                // size hints only need re-applying when the requested size moved
+                if (nw == last_nw && nh == last_nh)
+                    break;
+                last_nw = nw;
+                last_nh = nh;
+
                 if (client->isfloating)
                     resize(client, client->x, client->y, nw, nh, 1);
                 break;
         }
+        flush_bar_redraws();
     } while (ev.type != ButtonRelease);
 
     XWarpPointer(global_display, None, client->window, 0, 0, 0, 0, client->width + client->border_width - 1, client->height + client->border_width - 1);
@@ -1999,16 +2857,16 @@ fn void resizemouse(const ActionDetails *arg) {
 //     }
 // }
 
-fn void toggle_layout(const ActionDetails *arg) {
+void toggle_layout(const ActionDetails *arg) {
     all_monitors[selected_monitor].selected_layout ^= 1;
-    if (all_monitors[selected_monitor].selected_client) {
+    if (all_monitors[selected_monitor].selected_client != NoClient) {
         arrange(selected_monitor);
     } else {
-        drawbar(selected_monitor);
+        request_bar_redraw(selected_monitor);
     }
 }
 
-fn void setmfact(const ActionDetails *arg) {
+void setmfact(const ActionDetails *arg) {
     int new_fact = all_monitors[selected_monitor].mfact + arg->i;
 
     if(!Between(new_fact, 5, 95)) {
@@ -2019,7 +2877,7 @@ fn void setmfact(const ActionDetails *arg) {
     arrange(selected_monitor);
 }
 
-fn void sigstatusbar(const ActionDetails *arg) {
+void sigstatusbar(const ActionDetails *arg) {
     union sigval sv;
 
     if (!statussig)
@@ -2032,11 +2890,11 @@ fn void sigstatusbar(const ActionDetails *arg) {
     sigqueue(statuspid, SIGRTMIN + statussig, sv);
 }
 
-fn void spawn_action(const ActionDetails *arg) {
+void spawn_action(const ActionDetails *arg) {
     spawn((char const **)arg->v, 1);
 }
 
-fn void spawn_dmenu(const ActionDetails *unused) {
+void spawn_dmenu(const ActionDetails *unused) {
     char dmenu_monitor[] = {'0' + all_monitors[selected_monitor].num, 0 };
     char const *dmenucmd[] = {
         "dmenu_run",
@@ -2052,17 +2910,17 @@ fn void spawn_dmenu(const ActionDetails *unused) {
     spawn(dmenucmd, 1);
 }
 
-fn void spawn_brave(const ActionDetails *arg) {
+void spawn_brave(const ActionDetails *arg) {
     char const* browser_command[] = { "brave-browser", arg->v, NULL };
     spawn_and_reset_mode(browser_command);
 }
 
-fn void spawn_firefox(const ActionDetails *arg) {
+void spawn_firefox(const ActionDetails *arg) {
     char const* browser_command[] = { "firefox", "-P", arg->v, NULL };
     spawn_and_reset_mode(browser_command);
 }
 
-fn void spawn_surf(const ActionDetails *arg) {
+void spawn_surf(const ActionDetails *arg) {
     char const* surf_command[] = {
         "tabbed", "-r", "5", // 5 is the index of the argument to switch out with the window id
         "firejail", "--noprofile", "--hosts-file=~/.surf/blocked-hosts.txt",
@@ -2073,17 +2931,19 @@ fn void spawn_surf(const ActionDetails *arg) {
     spawn_and_reset_mode(surf_command);
 }
 
-fn void tag(const ActionDetails *arg) {
-    Client *selected_client = all_monitors[selected_monitor].selected_client;
+void tag(const ActionDetails *arg) {
+    Client *selected_client = get_client(all_monitors[selected_monitor].selected_client);
     if (selected_client && arg->ui & TagMask) {
+        occupancy_remove(selected_client);
         selected_client->tags = arg->ui & TagMask;
+        occupancy_add(selected_client);
         focus(NULL);
         arrange(selected_monitor);
     }
 }
 
-fn void tagmon(const ActionDetails *arg) {
-    Client *selected_client = all_monitors[selected_monitor].selected_client;
+void tagmon(const ActionDetails *arg) {
+    Client *selected_client = get_client(all_monitors[selected_monitor].selected_client);
     if (!selected_client)
         return;
 
@@ -2093,9 +2953,9 @@ fn void tagmon(const ActionDetails *arg) {
     }
 }
 
-fn void togglefloating(const ActionDetails *arg) {
+void togglefloating(const ActionDetails *arg) {
     Monitor *monitor = &all_monitors[selected_monitor];
-    Client *selected_client = monitor->selected_client;
+    Client *selected_client = get_client(monitor->selected_client);
 
     if (selected_client && !selected_client->isfullscreen) {
         /* no support for fullscreen windows */
@@ -2113,21 +2973,23 @@ fn void togglefloating(const ActionDetails *arg) {
     }
 }
 
-fn void toggletag(const ActionDetails *arg) {
+void toggletag(const ActionDetails *arg) {
     unsigned int newtags;
 
-    Client *selected_client = all_monitors[selected_monitor].selected_client;
+    Client *selected_client = get_client(all_monitors[selected_monitor].selected_client);
     if (!selected_client)
         return;
     newtags = selected_client->tags ^ (arg->ui & TagMask);
     if (newtags) {
+        occupancy_remove(selected_client);
         selected_client->tags = newtags;
+        occupancy_add(selected_client);
         focus(NULL);
         arrange(selected_monitor);
     }
 }
 
-fn void toggleview(const ActionDetails *arg) {
+void toggleview(const ActionDetails *arg) {
     unsigned int newtagset = all_monitors[selected_monitor].selected_tags ^ (arg->ui & TagMask);
     if (newtagset) {
         all_monitors[selected_monitor].selected_tags = newtagset;
@@ -2136,8 +2998,8 @@ fn void toggleview(const ActionDetails *arg) {
     }
 }
 
-fn void resize_window(const ActionDetails *arg) {
-    Client *selected_client = all_monitors[selected_monitor].selected_client;
+void resize_window(const ActionDetails *arg) {
+    Client *selected_client = get_client(all_monitors[selected_monitor].selected_client);
     int resize_amount = arg->i > 0 ? 5 : -5;
 
     if (selected_client && selected_client->isfloating) {
@@ -2156,8 +3018,8 @@ fn void resize_window(const ActionDetails *arg) {
     }
 }
 
-fn void move_vert(const ActionDetails *arg) {
-    Client *selected_client = all_monitors[selected_monitor].selected_client;
+void move_vert(const ActionDetails *arg) {
+    Client *selected_client = get_client(all_monitors[selected_monitor].selected_client);
 
     int move_amount = arg->i > 0 ? 5 : -5;
     if(selected_client && selected_client->isfloating) {
@@ -2170,8 +3032,8 @@ fn void move_vert(const ActionDetails *arg) {
     }
 }
 
-fn void move_horiz(const ActionDetails *arg) {
-    Client *selected_client = all_monitors[selected_monitor].selected_client;
+void move_horiz(const ActionDetails *arg) {
+    Client *selected_client = get_client(all_monitors[selected_monitor].selected_client);
 
     int move_amount = arg->i > 0 ? 5 : -5;
     if(selected_client && selected_client->isfloating) {
@@ -2179,8 +3041,8 @@ fn void move_horiz(const ActionDetails *arg) {
     }
 }
 
-fn void change_window_aspect_ratio(const ActionDetails *arg) {
-    Client *selected_client = all_monitors[selected_monitor].selected_client;
+void change_window_aspect_ratio(const ActionDetails *arg) {
+    Client *selected_client = get_client(all_monitors[selected_monitor].selected_client);
 
     int resize_amount = arg->i > 0 ? 5 : -5;
     if(selected_client && selected_client->isfloating) {
@@ -2193,8 +3055,8 @@ fn void change_window_aspect_ratio(const ActionDetails *arg) {
     }
 }
 
-fn void killclient(const ActionDetails *arg) {
-    Client *selected_client = all_monitors[selected_monitor].selected_client;
+void killclient(const ActionDetails *arg) {
+    Client *selected_client = get_client(all_monitors[selected_monitor].selected_client);
     if (!selected_client)
         return;
 
@@ -2209,7 +3071,7 @@ fn void killclient(const ActionDetails *arg) {
     }
 }
 
-fn void view(const ActionDetails *arg) {
+void view(const ActionDetails *arg) {
     int new_tags = arg->ui & TagMask;
     Monitor *monitor = &all_monitors[selected_monitor];
     if (new_tags != monitor->selected_tags) {
@@ -2221,7 +3083,7 @@ fn void view(const ActionDetails *arg) {
     }
 }
 
-fn void focusmon(const ActionDetails *arg) {
+void focusmon(const ActionDetails *arg) {
     int monitor_index;
     if ((monitor_index = dirtomon(arg->i)) == selected_monitor)
         return;
@@ -2229,21 +3091,22 @@ fn void focusmon(const ActionDetails *arg) {
     set_current_monitor(monitor_index);
 }
 
-fn void focusstack(const ActionDetails *arg) {
+void focusstack(const ActionDetails *arg) {
     Client *client = NULL, *i;
 
     Monitor *monitor = &all_monitors[selected_monitor];
-    if (monitor->selected_client && !monitor->selected_client->isfullscreen) {
+    Client *selected_client = get_client(monitor->selected_client);
+    if (selected_client && !selected_client->isfullscreen) {
         if (arg->i > 0) {
-            for (client = monitor->selected_client->next; client && !IsVisible(client); client = client->next);
+            for (client = get_client(selected_client->next); client && !IsVisible(client); client = get_client(client->next));
             if (!client)
-                for (client = monitor->clients; client && !IsVisible(client); client = client->next);
+                for (client = get_client(monitor->clients); client && !IsVisible(client); client = get_client(client->next));
         } else {
-            for (i = monitor->clients; i != monitor->selected_client; i = i->next)
+            for (i = get_client(monitor->clients); i != selected_client; i = get_client(i->next))
                 if (IsVisible(i))
                     client = i;
             if (!client)
-                for (; i; i = i->next)
+                for (; i; i = get_client(i->next))
                     if (IsVisible(i))
                         client = i;
         }
@@ -2255,11 +3118,11 @@ fn void focusstack(const ActionDetails *arg) {
     }
 }
 
-fn void push_mode_action(const ActionDetails *arg) {
+void push_mode_action(const ActionDetails *arg) {
     push_mode(arg->i);
 }
 
-fn void pop_mode_action(const ActionDetails *arg) {
+void pop_mode_action(const ActionDetails *arg) {
     pop_mode();
 }
 
@@ -2298,13 +3161,83 @@ fn void pop_mode_action(const ActionDetails *arg) {
 // }
 
 // Status bar
-fn ChildProcess start_status_bar(void) {
+fn void start_status_bar(void) {
     // If the status bar handles its own click events, why do we need wm_to_status?
     // wm_to_status tells the status bar which tags to show
     // status_to_wm tells dwm what was clicked
     char const* args[] = { STATUSBAR, NULL };
-    ChildProcess result = spawn(args, 0);
-    return result;
+
+    // throttle restarts so a status bar that dies instantly can't wedge dwm
+    // in a fork loop; a throttled (or failed) attempt is deferred, not
+    // dropped: the main loop polls with a timeout while one is pending and
+    // calls back in once the window has passed
+    time_t now = time(NULL);
+    if (now - status_bar_last_restart < 2) {
+        status_bar_restart_pending = 1;
+        return;
+    }
+    status_bar_last_restart = now;
+    status_bar_restart_pending = 0;
+
+    status_bar_process = spawn(args, 0);
+    if (status_bar_process.pid > 0) {
+        statuspid = status_bar_process.pid; // remember it so sigstatusbar never has to go looking
+        fcntl(status_bar_process.std_output, F_SETFL, O_NONBLOCK);
+    } else {
+        status_bar_restart_pending = 1;
+    }
+}
+
+fn void stop_status_bar(void) {
+    if (status_bar_process.pid > 0) {
+        kill(status_bar_process.pid, SIGTERM);
+        close(status_bar_process.std_output);
+        close(status_bar_process.std_input);
+    }
+    status_bar_process = (ChildProcess){0};
+}
+
+// Drain whatever the status bar has written so far. Updates arrive as one
+// line per status; only the newest complete line is kept, so a bar that
+// writes faster than we paint just collapses into a single redraw.
+fn void read_status_bar_pipe(void) {
+    static char pending[sizeof(status_text)];
+    static size_t pending_length;
+    char buffer[256];
+    int status_changed = 0;
+
+    for (;;) {
+        ssize_t bytes_read = read(status_bar_process.std_output, buffer, sizeof(buffer));
+        if (bytes_read > 0) {
+            for (ssize_t i = 0; i < bytes_read; ++i) {
+                if (buffer[i] == '\n') {
+                    pending[pending_length] = '\0';
+                    // Identical ticks (clock seconds stripped, OSD repeats)
+                    // leave the cached status segment valid; don't redraw.
+                    if (strcmp(status_text, pending) != 0) {
+                        strcpy(status_text, pending);
+                        status_changed = 1;
+                    }
+                    pending_length = 0;
+                } else if (pending_length < sizeof(pending) - 1) {
+                    pending[pending_length++] = buffer[i];
+                }
+            }
+        } else if (bytes_read < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else {
+            // EOF or hard error: the bar is gone, revive it
+            stop_status_bar();
+            pending_length = 0;
+            start_status_bar();
+            break;
+        }
+    }
+
+    if (status_changed) {
+        refresh_status_width();
+        request_bar_redraw(selected_monitor);
+    }
 }
 
 /* Startup Error handler to check if another window manager is already running. */
@@ -2331,6 +3264,12 @@ fn void setup(Display *display) {
     /* clean up any zombies immediately */
     sigchld(0);
 
+    if (signal(SIGUSR1, trace_sigusr1) == SIG_ERR)
+        die("can't install SIGUSR1 handler:");
+
+    if (signal(SIGHUP, config_sighup) == SIG_ERR)
+        die("can't install SIGHUP handler:");
+
     /* init screen */
     global_screen = DefaultScreen(display);
     global_screen_width = DisplayWidth(display, global_screen);
@@ -2374,8 +3313,7 @@ fn void setup(Display *display) {
     }
 
     /* init bars */
-    unused(start_status_bar);
-    // start_status_bar();
+    start_status_bar();
     updatebars();
     updatestatus();
     /* supporting window for NetWMCheck */
@@ -2397,7 +3335,10 @@ fn void setup(Display *display) {
       |LeaveWindowMask|StructureNotifyMask|PropertyChangeMask;
     XChangeWindowAttributes(display, root, CWEventMask|CWCursor, &wa);
     XSelectInput(display, root, wa.event_mask);
+    init_button_buckets();
+    compile_rules();
     grabkeys();
+    load_config_module(); // swap in the dlopened tables if the module exists
     focus(NULL);
 }
 
@@ -2457,7 +3398,67 @@ int main(int argc, char *argv[]) {
     /* main event loop */
     XEvent event;
     XSync(global_display, False);
-    while (global_running && !XNextEvent(global_display, &event)) {
+    while (global_running) {
+        // paint deferred bar updates only when the burst has drained, so a
+        // storm of events costs one redraw instead of one per event
+        if (trace_dump_requested)
+            trace_dump();
+
+        if (config_reload_requested) {
+            config_reload_requested = 0;
+            load_config_module();
+        }
+
+        if (XPending(global_display) == 0) {
+            flush_bar_redraws();
+
+            // block on both the X connection and the status bar pipe so a
+            // status update never waits behind XNextEvent
+            struct pollfd fds[2] = {
+                { .fd = ConnectionNumber(global_display), .events = POLLIN },
+                { .fd = status_bar_process.std_output,    .events = POLLIN },
+            };
+            nfds_t fd_count = status_bar_process.pid > 0 ? 2 : 1;
+
+            // with no bar to watch but a restart pending, wake up when the
+            // throttle window closes instead of blocking forever
+            int timeout = -1;
+            if (fd_count == 1 && status_bar_restart_pending) {
+                time_t wait = status_bar_last_restart + 2 - time(NULL);
+                timeout = wait > 0 ? (int)wait * 1000 : 0;
+            }
+
+            if (poll(fds, fd_count, timeout) < 0) {
+                if (errno == EINTR)
+                    continue;
+                break;
+            }
+
+            if (status_bar_restart_pending && status_bar_process.pid <= 0)
+                start_status_bar();
+
+            if (fd_count == 2 && (fds[1].revents & (POLLIN|POLLHUP|POLLERR)))
+                read_status_bar_pipe();
+
+            if (XPending(global_display) == 0)
+                continue;
+        }
+
+        if (XNextEvent(global_display, &event))
+            break;
+
+        unsigned long long trace_start = trace_clock();
+        unsigned int trace_id;
+        switch (event.type) {
+            default:               trace_id = TraceOtherEvent;       break;
+            case ButtonPress:      trace_id = TraceButtonPress;      break;
+            case KeyPress:         trace_id = TraceKeyPress;         break;
+            case ConfigureRequest: trace_id = TraceConfigureRequest; break;
+            case MapRequest:       trace_id = TraceMapRequest;       break;
+            case MotionNotify:     trace_id = TraceMotionNotify;     break;
+            case PropertyNotify:   trace_id = TracePropertyNotify;   break;
+        }
+
         switch (event.type) {
             case ButtonPress: {
                 buttonpress(&event);
@@ -2475,7 +3476,7 @@ int main(int argc, char *argv[]) {
                             setfullscreen(client, (cme->data.l[0] == 1 /* _NET_WM_STATE_ADD    */
                                                    || (cme->data.l[0] == 2 /* _NET_WM_STATE_TOGGLE */ && !client->isfullscreen)));
                     } else if (cme->message_type == netatom[NetActiveWindow]) {
-                        if (client != all_monitors[selected_monitor].selected_client && !client->isurgent)
+                        if (client_index(client) != all_monitors[selected_monitor].selected_client && !client->isurgent)
                             seturgent(client, 1);
                     }
                 }
@@ -2499,12 +3500,11 @@ int main(int argc, char *argv[]) {
                     global_screen_height = ev->height;
 
                     if (updategeom() || dirty) {
-                        drw_resize(&drw, global_screen_width, global_bar_height);
-                        updatebars();
+                        updatebars(); // recreates per-monitor bar buffers at the new widths
                         for (int monitor_index = 0; monitor_index < monitor_capacity; ++monitor_index) {
                             Monitor *monitor = &all_monitors[monitor_index];
                             if(monitor->is_valid) {
-                                for (client = monitor->clients; client; client = client->next) {
+                                for (client = get_client(monitor->clients); client; client = get_client(client->next)) {
                                     if (client->isfullscreen) {
                                         resizeclient(client, monitor->screen_x, monitor->screen_y, monitor->screen_width, monitor->screen_height);
                                     }
@@ -2532,13 +3532,17 @@ int main(int argc, char *argv[]) {
                 Client *client;
                 XCrossingEvent *ev = &event.xcrossing;
 
+                // crossings generated by our own restacking, not the pointer
+                if (ev->serial <= enter_notify_ignore_serial)
+                    break;
+
                 if ((ev->mode == NotifyNormal && ev->detail != NotifyInferior) || ev->window == root) {
                     client = wintoclient(ev->window);
                     int monitor_index = client ? client->monitor : wintomon(ev->window);
                     if (monitor_index != selected_monitor) {
-                        unfocus(all_monitors[selected_monitor].selected_client, 1);
+                        unfocus(get_client(all_monitors[selected_monitor].selected_client), 1);
                         selected_monitor = monitor_index;
-                    } else if (client && client != all_monitors[selected_monitor].selected_client) {
+                    } else if (client && client_index(client) != all_monitors[selected_monitor].selected_client) {
                         focus(client);
                     }
                 }
@@ -2554,7 +3558,7 @@ int main(int argc, char *argv[]) {
                 /* there are some broken focus acquiring clients needing extra handling */
                 XFocusChangeEvent *ev = &event.xfocus;
 
-                Client *selected_client = all_monitors[selected_monitor].selected_client;
+                Client *selected_client = get_client(all_monitors[selected_monitor].selected_client);
                 if (selected_client && ev->window != selected_client->window)
                     setfocus(selected_client);
                 break;
@@ -2562,17 +3566,16 @@ int main(int argc, char *argv[]) {
 
             case KeyPress: {
                 XKeyEvent *ev = &event.xkey;
-                KeySym keysym = XKeycodeToKeysym(global_display, (KeyCode)ev->keycode, 0);
 
-                unsigned int i = 0;
                 int current_mode = mode_stack[mode_stack_top];
-                Key* key_array = (Key*)keys[current_mode].content;
-                int length = keys[current_mode].length;
-
-                for(; i < length; i++) {
-                    Key* key = &key_array[i];
-                    if (keysym == key->keysym &&
-                        CleanMask(key->mod) == CleanMask(ev->state)) {
+                Key* key_array = (Key*)config->keys[current_mode].content;
+                unsigned int cleaned_state = CleanMask(ev->state);
+
+                for (int key_index = key_dispatch_head[ev->keycode & 0xff];
+                     key_index != NoKeyBinding;
+                     key_index = key_dispatch_next[key_index]) {
+                    if (key_dispatch_mask[key_index] == cleaned_state) {
+                        Key* key = &key_array[key_index];
                         key->func(&(key->arg));
                         break;
                     }
@@ -2585,7 +3588,8 @@ int main(int argc, char *argv[]) {
                 XMappingEvent *ev = &event.xmapping;
 
                 XRefreshKeyboardMapping(ev);
-                if (ev->request == MappingKeyboard) {
+                if (ev->request == MappingKeyboard || ev->request == MappingModifier) {
+                    numlockmask_valid = 0;
                     grabkeys();
                 }
 
@@ -2599,12 +3603,16 @@ int main(int argc, char *argv[]) {
 
             case MotionNotify: {
                 static int previous_monitor_index = -1;
+
+                // only the endpoint of a motion burst matters
+                while (XCheckTypedWindowEvent(global_display, root, MotionNotify, &event));
+
                 XMotionEvent *ev = &event.xmotion;
 
                 if (ev->window == root) {
                     int monitor_index = recttomon(ev->x_root, ev->y_root, 1, 1);
                     if (monitor_index != previous_monitor_index && Between(previous_monitor_index, 0, monitor_capacity - 1)) {
-                        unfocus(all_monitors[selected_monitor].selected_client, 1);
+                        unfocus(get_client(all_monitors[selected_monitor].selected_client), 1);
                         selected_monitor = monitor_index;
                         focus(NULL);
                     }
@@ -2632,7 +3640,8 @@ int main(int argc, char *argv[]) {
                                      arrange(client->monitor);
                                  break;
                         case XA_WM_NORMAL_HINTS:
-                                 updatesizehints(client);
+                                 // refetched lazily by applysizehints()
+                                 client->size_hints_valid = 0;
                                  break;
                         case XA_WM_HINTS:
                                  updatewmhints(client);
@@ -2641,11 +3650,13 @@ int main(int argc, char *argv[]) {
                     }
                     if (ev->atom == XA_WM_NAME || ev->atom == netatom[NetWMName]) {
                         updatetitle(client);
-                        if (client == all_monitors[client->monitor].selected_client)
-                            drawbar(client->monitor);
+                        if (client_index(client) == all_monitors[client->monitor].selected_client)
+                            request_bar_redraw(client->monitor);
                     }
                     if (ev->atom == netatom[NetWMWindowType])
                         updatewindowtype(client);
+                    if (ev->atom == wmatom[WMProtocols])
+                        updatewmprotocols(client);
                 }
                 break;
             }
@@ -2663,6 +3674,7 @@ int main(int argc, char *argv[]) {
                 break;
             }
         }
+        trace_end(trace_id, trace_start);
 
         // if (handler[event.type]) {
         //     handler[event.type](&event); /* call handler */
@@ -2670,6 +3682,8 @@ int main(int argc, char *argv[]) {
     }
 
     // cleanup
+    stop_status_bar();
+
     ActionDetails a = { .ui = ~0 };
 
     view(&a);
@@ -2677,8 +3691,8 @@ int main(int argc, char *argv[]) {
     for (int monitor_index = 0; monitor_index < monitor_capacity; ++monitor_index) {
         Monitor *monitor = &all_monitors[monitor_index];
         if(monitor->is_valid) {
-            while (monitor->stack)
-                unmanage(monitor->stack, 0);
+            while (monitor->stack != NoClient)
+                unmanage(&all_clients[monitor->stack], 0);
         }
     }
 
@@ -0,0 +1,64 @@
+/* See LICENSE file for copyright and license details. */
+#include <stdlib.h>
+#include <string.h>
+
+#include "pool.h"
+#include "util.h"
+
+void *pool_bucket(Pool *pool, int bucket) {
+    return (char *)pool->items + (size_t)bucket * pool->item_size;
+}
+
+static void pool_add_buckets(Pool *pool, int first_new) {
+    // chain the new buckets onto the free list front-to-back so the lowest
+    // index is handed out first
+    for (int bucket = pool->capacity - 1; bucket >= first_new; --bucket) {
+        pool->tags[bucket].is_used = 0;
+        pool->tags[bucket].next_free = pool->free_head;
+        pool->free_head = bucket;
+    }
+}
+
+void pool_init(Pool *pool, size_t item_size, int initial_capacity) {
+    pool->item_size = item_size;
+    pool->capacity = initial_capacity;
+    pool->free_head = PoolNoBucket;
+    pool->items = ecalloc(initial_capacity, item_size);
+    pool->tags = ecalloc(initial_capacity, sizeof(PoolBucketTag));
+    pool_add_buckets(pool, 0);
+}
+
+int pool_alloc(Pool *pool) {
+    if (pool->free_head == PoolNoBucket) {
+        int old_capacity = pool->capacity;
+        int new_capacity = old_capacity << 1;
+
+        void *new_items = ecalloc(new_capacity, pool->item_size);
+        memcpy(new_items, pool->items, (size_t)old_capacity * pool->item_size);
+        free(pool->items);
+        pool->items = new_items;
+
+        PoolBucketTag *new_tags = ecalloc(new_capacity, sizeof(PoolBucketTag));
+        memcpy(new_tags, pool->tags, old_capacity * sizeof(PoolBucketTag));
+        free(pool->tags);
+        pool->tags = new_tags;
+
+        pool->capacity = new_capacity;
+        pool_add_buckets(pool, old_capacity);
+    }
+
+    int bucket = pool->free_head;
+    pool->free_head = pool->tags[bucket].next_free;
+    pool->tags[bucket].is_used = 1;
+    memset(pool_bucket(pool, bucket), 0, pool->item_size);
+    return bucket;
+}
+
+void pool_free_bucket(Pool *pool, int bucket) {
+    if (!pool->tags[bucket].is_used)
+        return;
+
+    pool->tags[bucket].is_used = 0;
+    pool->tags[bucket].next_free = pool->free_head;
+    pool->free_head = bucket;
+}
@@ -0,0 +1,30 @@
+/* See LICENSE file for copyright and license details. */
+
+/* Free-list pool allocator. Items of one size live in a contiguous slab and
+ * are addressed by bucket index. Each bucket has a tag that records whether
+ * it is in use and threads the free list, so allocating and releasing are
+ * O(1) and iterating over valid/invalid buckets never touches the items
+ * themselves. The slab grows by doubling; growth moves the items, so anyone
+ * caching the items pointer must re-read it after pool_alloc(). */
+
+#define PoolNoBucket (-1)
+
+typedef struct PoolBucketTag PoolBucketTag;
+struct PoolBucketTag {
+    int is_used;
+    int next_free; // index of the next free bucket, PoolNoBucket when none
+};
+
+typedef struct Pool Pool;
+struct Pool {
+    void *items;
+    PoolBucketTag *tags;
+    size_t item_size;
+    int capacity;
+    int free_head; // index of the first free bucket, PoolNoBucket when full
+};
+
+void pool_init(Pool *pool, size_t item_size, int initial_capacity);
+int pool_alloc(Pool *pool);
+void pool_free_bucket(Pool *pool, int bucket);
+void *pool_bucket(Pool *pool, int bucket);